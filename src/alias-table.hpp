@@ -0,0 +1,126 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2023, Arizona Board of Regents.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NDNTG_ALIAS_TABLE_HPP
+#define NDNTG_ALIAS_TABLE_HPP
+
+#include <cstddef>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace ndntg {
+
+/**
+ * \brief Samples from a discrete probability distribution in constant time.
+ *
+ * This is Vose's variant of Walker's alias method: building the table takes O(n),
+ * and every sample costs one uniform integer, one uniform real, and one comparison.
+ * The weights do not need to be normalized.
+ */
+class AliasTable
+{
+public:
+  AliasTable() = default;
+
+  explicit
+  AliasTable(const std::vector<double>& weights)
+  {
+    double total = 0.0;
+    for (auto w : weights) {
+      if (w > 0.0) {
+        total += w;
+      }
+    }
+    if (!(total > 0.0)) {
+      return;
+    }
+
+    auto n = weights.size();
+    m_probability.resize(n);
+    m_alias.resize(n);
+
+    std::vector<double> scaled(n);
+    std::vector<std::size_t> small, large;
+    for (std::size_t i = 0; i < n; i++) {
+      scaled[i] = weights[i] > 0.0 ? weights[i] * n / total : 0.0;
+      (scaled[i] < 1.0 ? small : large).push_back(i);
+    }
+
+    while (!small.empty() && !large.empty()) {
+      auto s = small.back();
+      small.pop_back();
+      auto l = large.back();
+
+      m_probability[s] = scaled[s];
+      m_alias[s] = l;
+      scaled[l] -= 1.0 - scaled[s];
+      if (scaled[l] < 1.0) {
+        large.pop_back();
+        small.push_back(l);
+      }
+    }
+    // whatever is left has probability 1, up to rounding errors
+    for (auto i : large) {
+      m_probability[i] = 1.0;
+      m_alias[i] = i;
+    }
+    for (auto i : small) {
+      m_probability[i] = 1.0;
+      m_alias[i] = i;
+    }
+  }
+
+  bool
+  empty() const
+  {
+    return m_probability.empty();
+  }
+
+  std::size_t
+  size() const
+  {
+    return m_probability.size();
+  }
+
+  /**
+   * \brief Draws an index with probability proportional to its weight.
+   * \return the index, or nullopt if the table is empty
+   */
+  template<typename RandomEngine>
+  std::optional<std::size_t>
+  sample(RandomEngine& rng) const
+  {
+    if (m_probability.empty()) {
+      return std::nullopt;
+    }
+
+    std::uniform_int_distribution<std::size_t> indexDist(0, m_probability.size() - 1);
+    std::uniform_real_distribution<double> coinDist(0.0, 1.0);
+    auto i = indexDist(rng);
+    return coinDist(rng) < m_probability[i] ? i : m_alias[i];
+  }
+
+private:
+  std::vector<double> m_probability;
+  std::vector<std::size_t> m_alias;
+};
+
+} // namespace ndntg
+
+#endif // NDNTG_ALIAS_TABLE_HPP
@@ -0,0 +1,80 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2023, Arizona Board of Regents.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "allocation-counter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace ndntg {
+
+thread_local uint64_t g_nAllocations = 0;
+
+static void*
+allocate(std::size_t size)
+{
+  g_nAllocations++;
+  while (true) {
+    if (void* p = std::malloc(size == 0 ? 1 : size); p != nullptr) {
+      return p;
+    }
+    auto handler = std::get_new_handler();
+    if (handler == nullptr) {
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+}
+
+} // namespace ndntg
+
+void*
+operator new(std::size_t size)
+{
+  return ndntg::allocate(size);
+}
+
+void*
+operator new[](std::size_t size)
+{
+  return ndntg::allocate(size);
+}
+
+void
+operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void
+operator delete[](void* p) noexcept
+{
+  std::free(p);
+}
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+void
+operator delete[](void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
@@ -0,0 +1,38 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2023, Arizona Board of Regents.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NDNTG_ALLOCATION_COUNTER_HPP
+#define NDNTG_ALLOCATION_COUNTER_HPP
+
+#include <cstdint>
+
+namespace ndntg {
+
+/**
+ * \brief Number of C++ heap allocations made by the current thread.
+ *
+ * The counter is maintained by the replacement of the global operator new in
+ * allocation-counter.cpp, which costs one thread-local increment per allocation, so every
+ * program that reads it must be linked with that file. Allocations made with malloc()
+ * directly, e.g. inside the crypto library, are not counted.
+ */
+extern thread_local uint64_t g_nAllocations;
+
+} // namespace ndntg
+
+#endif // NDNTG_ALLOCATION_COUNTER_HPP
@@ -0,0 +1,183 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2023, Arizona Board of Regents.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NDNTG_ARRIVAL_PROCESS_HPP
+#define NDNTG_ARRIVAL_PROCESS_HPP
+
+#include <ndn-cxx/util/random.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/algorithm/string/split.hpp>
+
+namespace ndntg {
+
+/**
+ * \brief Determines the spacing between consecutive Interests.
+ *
+ * The textual representation is one of:
+ *  - `fixed`: constant gaps equal to the configured interval (default)
+ *  - `poisson`: exponentially distributed gaps with the configured interval as mean
+ *  - `onoff:ON:OFF`: constant gaps during ON milliseconds, followed by OFF milliseconds of silence
+ *  - `ramp:FROM:TO:SECONDS`: the rate grows linearly from FROM to TO times the configured rate
+ *    over SECONDS seconds, then stays constant
+ */
+class ArrivalProcess
+{
+public:
+  enum class Type {
+    FIXED,
+    POISSON,
+    ON_OFF,
+    RAMP,
+  };
+
+  ArrivalProcess() = default;
+
+  /**
+   * \throw std::invalid_argument the string is not a valid arrival process
+   */
+  static ArrivalProcess
+  parse(const std::string& input)
+  {
+    std::vector<std::string> tokens;
+    boost::algorithm::split(tokens, input, [] (char c) { return c == ':'; });
+
+    auto fail = [&input] {
+      throw std::invalid_argument("'" + input + "' is not a valid arrival process");
+    };
+    auto toNumber = [&] (const std::string& token) {
+      std::size_t pos = 0;
+      double d = 0.0;
+      try {
+        d = std::stod(token, &pos);
+      }
+      catch (const std::exception&) {
+        fail();
+      }
+      if (pos != token.size() || !(d > 0) || !std::isfinite(d)) {
+        fail();
+      }
+      return d;
+    };
+
+    ArrivalProcess process;
+    if (tokens[0] == "fixed" && tokens.size() == 1) {
+      process.m_type = Type::FIXED;
+    }
+    else if (tokens[0] == "poisson" && tokens.size() == 1) {
+      process.m_type = Type::POISSON;
+    }
+    else if (tokens[0] == "onoff" && tokens.size() == 3) {
+      process.m_type = Type::ON_OFF;
+      process.m_onDuration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::duration<double, std::milli>(toNumber(tokens[1])));
+      process.m_offDuration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::duration<double, std::milli>(toNumber(tokens[2])));
+    }
+    else if (tokens[0] == "ramp" && tokens.size() == 4) {
+      process.m_type = Type::RAMP;
+      process.m_rampFrom = toNumber(tokens[1]);
+      process.m_rampTo = toNumber(tokens[2]);
+      process.m_rampDuration = toNumber(tokens[3]);
+    }
+    else {
+      fail();
+    }
+    return process;
+  }
+
+  Type
+  getType() const
+  {
+    return m_type;
+  }
+
+  /**
+   * \brief Computes when the arrival following \p previous takes place.
+   * \param previous time of the previous arrival, relative to the start of the process
+   * \param interval mean interval between arrivals at the nominal rate
+   * \return time of the next arrival, relative to the start of the process
+   */
+  std::chrono::nanoseconds
+  getNextArrival(std::chrono::nanoseconds previous, std::chrono::nanoseconds interval) const
+  {
+    using std::chrono::nanoseconds;
+
+    switch (m_type) {
+      case Type::FIXED:
+        break;
+      case Type::POISSON: {
+        std::exponential_distribution<double> dist(1.0);
+        return previous + nanoseconds(static_cast<nanoseconds::rep>(
+                                        dist(ndn::random::getRandomNumberEngine()) * interval.count()));
+      }
+      case Type::ON_OFF: {
+        auto next = previous + interval;
+        auto phase = next % (m_onDuration + m_offDuration);
+        if (phase >= m_onDuration) {
+          // skip the rest of the silent period
+          next += m_onDuration + m_offDuration - phase;
+        }
+        return next;
+      }
+      case Type::RAMP: {
+        double progress = std::min(1.0, std::chrono::duration<double>(previous).count() / m_rampDuration);
+        double factor = m_rampFrom + (m_rampTo - m_rampFrom) * progress;
+        return previous + nanoseconds(static_cast<nanoseconds::rep>(interval.count() / factor));
+      }
+    }
+    return previous + interval;
+  }
+
+  friend std::ostream&
+  operator<<(std::ostream& os, const ArrivalProcess& process)
+  {
+    switch (process.m_type) {
+      case Type::FIXED:
+        return os << "fixed";
+      case Type::POISSON:
+        return os << "poisson";
+      case Type::ON_OFF:
+        return os << "onoff:" << std::chrono::duration<double, std::milli>(process.m_onDuration).count()
+                  << ':' << std::chrono::duration<double, std::milli>(process.m_offDuration).count();
+      case Type::RAMP:
+        return os << "ramp:" << process.m_rampFrom << ':' << process.m_rampTo << ':' << process.m_rampDuration;
+    }
+    return os;
+  }
+
+private:
+  Type m_type = Type::FIXED;
+  std::chrono::nanoseconds m_onDuration{0};
+  std::chrono::nanoseconds m_offDuration{0};
+  double m_rampFrom = 1.0;
+  double m_rampTo = 1.0;
+  double m_rampDuration = 1.0; // seconds
+};
+
+} // namespace ndntg
+
+#endif // NDNTG_ARRIVAL_PROCESS_HPP
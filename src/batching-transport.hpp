@@ -0,0 +1,866 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2023, Arizona Board of Regents.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NDNTG_BATCHING_TRANSPORT_HPP
+#define NDNTG_BATCHING_TRANSPORT_HPP
+
+#include <ndn-cxx/encoding/block.hpp>
+#include <ndn-cxx/encoding/tlv.hpp>
+#include <ndn-cxx/face.hpp>
+#include <ndn-cxx/net/face-uri.hpp>
+#include <ndn-cxx/transport/transport.hpp>
+#include <ndn-cxx/util/config-file.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/variables_map.hpp>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+namespace ndntg {
+
+class BatchPolicy
+{
+public:
+  std::size_t m_maxPackets = 1; ///< a batch is written as soon as it has this many packets
+  std::chrono::microseconds m_maxDelay{0}; ///< zero: at the end of the current event loop turn
+  std::chrono::microseconds m_socketBusyPoll{0}; ///< SO_BUSY_POLL of the socket; zero: not set
+};
+
+class BatchStatistics
+{
+public:
+  void
+  merge(const BatchStatistics& other)
+  {
+    m_nBatches += other.m_nBatches;
+    m_nPackets += other.m_nPackets;
+  }
+
+  double
+  getAverageBatchSize() const
+  {
+    return m_nBatches == 0 ? 0.0 : static_cast<double>(m_nPackets) / m_nBatches;
+  }
+
+public:
+  uint64_t m_nBatches = 0;
+  uint64_t m_nPackets = 0;
+};
+
+/**
+ * \brief Face transport that writes the packets sent within a short period all at once.
+ *
+ * The default ndn-cxx transports make one write system call per packet. This transport
+ * queues the packets instead, and writes them out in one gather write (writev) when
+ * BatchPolicy::m_maxPackets are queued, when BatchPolicy::m_maxDelay has elapsed since the
+ * first of them was queued or, if the delay is zero, once the event loop has run the
+ * handlers that were ready when it was queued. Packets sent while a batch is being written
+ * are written as soon as it completes.
+ *
+ * A transport is used by a single Face, on the thread of its io_context.
+ */
+class BatchingTransport : public ndn::Transport, public std::enable_shared_from_this<BatchingTransport>
+{
+public:
+  /**
+   * \brief Returns the FaceUri of the forwarder that ndn-cxx applications connect to,
+   *        as per the NDN_CLIENT_TRANSPORT environment variable or the client.conf file.
+   * \throw ndn::Transport::Error client.conf cannot be parsed
+   */
+  static std::string
+  getDefaultUri();
+
+  /**
+   * \brief Creates a transport to the forwarder at \p uri, which is one of `unix://PATH`,
+   *        `tcp[46]://HOST[:PORT]`, or `udp[46]://HOST[:PORT]`.
+   * \param wantFixedPort bind a UDP socket to the port of \p uri, rather than to an ephemeral
+   *                      port, so that the forwarder can create a face towards this process
+   * \throw ndn::Transport::Error the FaceUri is invalid, unsupported, or cannot be resolved
+   */
+  static std::shared_ptr<BatchingTransport>
+  create(const std::string& uri, const BatchPolicy& policy, bool wantFixedPort = false);
+
+  /**
+   * \brief Returns whether the transport is connected to the forwarder over UDP.
+   *
+   * Such a forwarder is usually remote, and does not accept the prefix registration commands
+   * that a Face sends to the local forwarder.
+   */
+  virtual bool
+  isDatagram() const
+  {
+    return false;
+  }
+
+  void
+  connect(boost::asio::io_context& io, ReceiveCallback receiveCallback) override
+  {
+    Transport::connect(io, std::move(receiveCallback));
+    m_flushTimer.emplace(io);
+  }
+
+  void
+  send(const ndn::Block& wire) final
+  {
+    m_queue.push_back(wire);
+    if (!m_isConnected || m_isWriting) {
+      // the queue is written once connected, or once the current batch is written
+      return;
+    }
+    if (m_queue.size() >= m_policy.m_maxPackets) {
+      writeNextBatch();
+    }
+    else {
+      scheduleFlush();
+    }
+  }
+
+  const BatchStatistics&
+  getStatistics() const
+  {
+    return m_stats;
+  }
+
+protected:
+  explicit
+  BatchingTransport(const BatchPolicy& policy)
+    : m_policy(policy)
+  {
+  }
+
+  /**
+   * \brief Starts writing m_batch; the completion handler must call onBatchWritten().
+   */
+  virtual void
+  writeBatch() = 0;
+
+  /**
+   * \brief Applies the socket options of the policy to the connected socket \p fd.
+   * \throw ndn::Transport::Error
+   */
+  void
+  setSocketOptions(int fd)
+  {
+    if (m_policy.m_socketBusyPoll == std::chrono::microseconds::zero()) {
+      return;
+    }
+#ifdef SO_BUSY_POLL
+    int usec = static_cast<int>(m_policy.m_socketBusyPoll.count());
+    if (::setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &usec, sizeof(usec)) != 0) {
+      // more than net.core.busy_read requires CAP_NET_ADMIN
+      throw Error(std::string("cannot set SO_BUSY_POLL: ") + std::strerror(errno));
+    }
+#else
+    throw Error("SO_BUSY_POLL is not supported on this platform");
+#endif
+  }
+
+  void
+  onConnected()
+  {
+    m_isConnected = true;
+    if (!m_queue.empty()) {
+      writeNextBatch();
+    }
+  }
+
+  void
+  onBatchWritten()
+  {
+    m_isWriting = false;
+    m_batch.clear();
+    if (!m_queue.empty()) {
+      // these packets have already waited for a whole write
+      writeNextBatch();
+    }
+  }
+
+  /**
+   * \brief Drops the queued packets, when the transport is closed.
+   */
+  void
+  clearQueue()
+  {
+    m_queue.clear();
+    m_batch.clear();
+    m_isWriting = false;
+    m_isFlushScheduled = false;
+    if (m_flushTimer) {
+      m_flushTimer->cancel();
+    }
+  }
+
+private:
+  void
+  writeNextBatch()
+  {
+    auto n = std::min(m_queue.size(), m_policy.m_maxPackets);
+    m_batch.assign(std::make_move_iterator(m_queue.begin()), std::make_move_iterator(m_queue.begin() + n));
+    m_queue.erase(m_queue.begin(), m_queue.begin() + n);
+    m_stats.m_nBatches++;
+    m_stats.m_nPackets += n;
+    m_isWriting = true;
+    writeBatch();
+  }
+
+  void
+  scheduleFlush()
+  {
+    if (m_isFlushScheduled) {
+      return;
+    }
+    m_isFlushScheduled = true;
+
+    auto flush = [this, self = shared_from_this()] {
+      m_isFlushScheduled = false;
+      if (m_isConnected && !m_isWriting && !m_queue.empty()) {
+        writeNextBatch();
+      }
+    };
+    if (m_policy.m_maxDelay == std::chrono::microseconds::zero()) {
+      boost::asio::post(*m_ioCtx, std::move(flush));
+      return;
+    }
+    m_flushTimer->expires_after(m_policy.m_maxDelay);
+    m_flushTimer->async_wait([flush = std::move(flush)] (const boost::system::error_code& ec) {
+      if (!ec) {
+        flush();
+      }
+    });
+  }
+
+protected:
+  std::vector<ndn::Block> m_batch; ///< the packets being written
+  bool m_isWriting = false;
+
+private:
+  const BatchPolicy m_policy;
+  std::deque<ndn::Block> m_queue;
+  std::optional<boost::asio::steady_timer> m_flushTimer;
+  bool m_isFlushScheduled = false;
+  BatchStatistics m_stats;
+};
+
+/**
+ * \brief BatchingTransport over a Unix stream socket or a TCP connection.
+ */
+template<typename Protocol>
+class BatchingStreamTransport final : public BatchingTransport
+{
+public:
+  BatchingStreamTransport(typename Protocol::endpoint endpoint, const BatchPolicy& policy)
+    : BatchingTransport(policy)
+    , m_endpoint(std::move(endpoint))
+  {
+  }
+
+  void
+  connect(boost::asio::io_context& io, ReceiveCallback receiveCallback) final
+  {
+    // the Face calls connect() for every packet sent until the transport is connected
+    if (m_isConnecting) {
+      return;
+    }
+    m_isConnecting = true;
+    BatchingTransport::connect(io, std::move(receiveCallback));
+    m_socket.emplace(io);
+    m_inputBufferSize = 0;
+    m_socket->async_connect(m_endpoint, [this, self = shared_from_this()] (const boost::system::error_code& ec) {
+      if (ec == boost::asio::error::operation_aborted) {
+        return;
+      }
+      m_isConnecting = false;
+      if (ec) {
+        close();
+        throw Error("cannot connect to the forwarder: " + ec.message());
+      }
+      setSocketOptions(m_socket->native_handle());
+      onConnected();
+      if (m_isReceiving) {
+        receive();
+      }
+    });
+  }
+
+  void
+  close() final
+  {
+    m_isConnecting = false;
+    m_isConnected = false;
+    m_isReceiving = false;
+    if (m_socket) {
+      boost::system::error_code ec;
+      m_socket->cancel(ec);
+      m_socket->close(ec);
+    }
+    clearQueue();
+  }
+
+  void
+  pause() final
+  {
+    if (!m_isReceiving) {
+      return;
+    }
+    m_isReceiving = false;
+    // cancelling the read would abort the write as well, which then cancels the read itself
+    if (m_isReading && !m_isWriting) {
+      m_socket->cancel();
+    }
+  }
+
+  void
+  resume() final
+  {
+    if (m_isReceiving) {
+      return;
+    }
+    m_isReceiving = true;
+    if (m_isConnected && !m_isReading) {
+      receive();
+    }
+  }
+
+private:
+  void
+  writeBatch() final
+  {
+    m_buffers.clear();
+    for (const auto& block : m_batch) {
+      m_buffers.emplace_back(block.data(), block.size());
+    }
+    boost::asio::async_write(*m_socket, m_buffers,
+      [this, self = shared_from_this()] (const boost::system::error_code& ec, std::size_t) {
+        if (ec == boost::asio::error::operation_aborted) {
+          return;
+        }
+        if (ec) {
+          close();
+          throw Error("error while sending to the forwarder: " + ec.message());
+        }
+        onBatchWritten();
+        if (!m_isWriting && !m_isReceiving && m_isReading) {
+          m_socket->cancel();
+        }
+      });
+  }
+
+  void
+  receive()
+  {
+    m_isReading = true;
+    auto buffer = boost::asio::buffer(m_inputBuffer.data() + m_inputBufferSize,
+                                      m_inputBuffer.size() - m_inputBufferSize);
+    m_socket->async_receive(buffer, [this, self = shared_from_this()] (const boost::system::error_code& ec,
+                                                                       std::size_t nBytesReceived) {
+      m_isReading = false;
+      if (ec == boost::asio::error::operation_aborted) {
+        // resume() does not read again while the cancelled read is pending
+        if (m_isConnected && m_isReceiving) {
+          receive();
+        }
+        return;
+      }
+      if (ec) {
+        close();
+        throw Error(ec == boost::asio::error::eof ? "the forwarder closed the connection"
+                                                  : "error while receiving from the forwarder: " + ec.message());
+      }
+
+      m_inputBufferSize += nBytesReceived;
+      std::size_t offset = 0;
+      while (offset < m_inputBufferSize) {
+        auto [isOk, element] = ndn::Block::fromBuffer(ndn::make_span(m_inputBuffer.data() + offset,
+                                                                     m_inputBufferSize - offset));
+        if (!isOk) {
+          break;
+        }
+        offset += element.size();
+        m_receiveCallback(element);
+      }
+      if (offset == 0 && m_inputBufferSize == m_inputBuffer.size()) {
+        close();
+        throw Error("received a packet larger than " + std::to_string(ndn::MAX_NDN_PACKET_SIZE) + " bytes");
+      }
+      std::memmove(m_inputBuffer.data(), m_inputBuffer.data() + offset, m_inputBufferSize - offset);
+      m_inputBufferSize -= offset;
+
+      if (m_isReceiving && !m_isReading) {
+        receive();
+      }
+    });
+  }
+
+private:
+  typename Protocol::endpoint m_endpoint;
+  std::optional<typename Protocol::socket> m_socket;
+  std::vector<boost::asio::const_buffer> m_buffers;
+  std::array<uint8_t, ndn::MAX_NDN_PACKET_SIZE> m_inputBuffer;
+  std::size_t m_inputBufferSize = 0;
+  bool m_isConnecting = false;
+  bool m_isReading = false;
+};
+
+/**
+ * \brief BatchingTransport over UDP, directly to a forwarder that is usually remote.
+ *
+ * Every packet is sent in its own datagram, as is, so the NDNLPv2 headers added by the Face,
+ * e.g. NextHopFaceId, are kept, and every datagram received must contain exactly one packet.
+ * On Linux, a batch is sent with a single sendmmsg() call and up to RECEIVE_BATCH_SIZE
+ * datagrams are received with a single recvmmsg() call.
+ */
+class BatchingDatagramTransport final : public BatchingTransport
+{
+public:
+  using Protocol = boost::asio::ip::udp;
+
+  BatchingDatagramTransport(Protocol::endpoint endpoint, const BatchPolicy& policy, bool wantFixedPort)
+    : BatchingTransport(policy)
+    , m_endpoint(std::move(endpoint))
+    , m_wantFixedPort(wantFixedPort)
+  {
+  }
+
+  bool
+  isDatagram() const final
+  {
+    return true;
+  }
+
+  void
+  connect(boost::asio::io_context& io, ReceiveCallback receiveCallback) final
+  {
+    BatchingTransport::connect(io, std::move(receiveCallback));
+    m_socket.emplace(io, m_endpoint.protocol());
+    try {
+      if (m_wantFixedPort) {
+        m_socket->bind(Protocol::endpoint(m_endpoint.protocol(), m_endpoint.port()));
+      }
+      m_socket->connect(m_endpoint);
+      m_socket->non_blocking(true);
+      setSocketOptions(m_socket->native_handle());
+    }
+    catch (const boost::system::system_error& e) {
+      close();
+      throw Error(std::string("cannot connect to the forwarder: ") + e.what());
+    }
+    onConnected();
+    if (m_isReceiving) {
+      receive();
+    }
+  }
+
+  void
+  close() final
+  {
+    m_isConnected = false;
+    m_isReceiving = false;
+    if (m_socket) {
+      boost::system::error_code ec;
+      m_socket->cancel(ec);
+      m_socket->close(ec);
+    }
+    clearQueue();
+  }
+
+  void
+  pause() final
+  {
+    if (!m_isReceiving) {
+      return;
+    }
+    m_isReceiving = false;
+    // cancelling the wait for input would cancel the wait for output as well
+    if (m_isReading && !m_isWriting) {
+      m_socket->cancel();
+    }
+  }
+
+  void
+  resume() final
+  {
+    if (m_isReceiving) {
+      return;
+    }
+    m_isReceiving = true;
+    if (m_isConnected && !m_isReading) {
+      receive();
+    }
+  }
+
+private:
+  static bool
+  isWouldBlock(const boost::system::error_code& ec)
+  {
+    return ec == boost::asio::error::would_block || ec == boost::asio::error::try_again;
+  }
+
+  void
+  writeBatch() final
+  {
+    m_nSent = 0;
+    sendRemaining();
+  }
+
+  void
+  sendRemaining()
+  {
+    while (m_nSent < m_batch.size()) {
+      boost::system::error_code ec;
+      auto nSent = sendDatagrams(ec);
+      if (isWouldBlock(ec)) {
+        m_socket->async_wait(Protocol::socket::wait_write,
+          [this, self = shared_from_this()] (const boost::system::error_code& ec) {
+            if (ec != boost::asio::error::operation_aborted) {
+              sendRemaining();
+            }
+          });
+        return;
+      }
+      if (ec) {
+        close();
+        throw Error("error while sending to the forwarder: " + ec.message());
+      }
+      m_nSent += nSent;
+    }
+
+    onBatchWritten();
+    if (!m_isWriting && !m_isReceiving && m_isReading) {
+      m_socket->cancel();
+    }
+  }
+
+  /**
+   * \brief Sends as many of the unsent packets of m_batch as the socket accepts.
+   */
+  std::size_t
+  sendDatagrams(boost::system::error_code& ec)
+  {
+#ifdef __linux__
+    auto n = m_batch.size() - m_nSent;
+    m_iovecs.resize(n);
+    m_headers.resize(n);
+    for (std::size_t i = 0; i < n; i++) {
+      const auto& block = m_batch[m_nSent + i];
+      m_iovecs[i].iov_base = const_cast<uint8_t*>(block.data());
+      m_iovecs[i].iov_len = block.size();
+      m_headers[i] = {};
+      m_headers[i].msg_hdr.msg_iov = &m_iovecs[i];
+      m_headers[i].msg_hdr.msg_iovlen = 1;
+    }
+    int nSent = ::sendmmsg(m_socket->native_handle(), m_headers.data(), static_cast<unsigned int>(n), 0);
+    if (nSent < 0) {
+      ec.assign(errno, boost::system::system_category());
+      return 0;
+    }
+    return static_cast<std::size_t>(nSent);
+#else
+    const auto& block = m_batch[m_nSent];
+    m_socket->send(boost::asio::buffer(block.data(), block.size()), 0, ec);
+    return ec ? 0 : 1;
+#endif
+  }
+
+  void
+  receive()
+  {
+    m_isReading = true;
+    m_socket->async_wait(Protocol::socket::wait_read, [this, self = shared_from_this()] (const boost::system::error_code& ec) {
+      m_isReading = false;
+      if (ec == boost::asio::error::operation_aborted) {
+        // resume() does not wait again while the cancelled wait is pending
+        if (m_isConnected && m_isReceiving) {
+          receive();
+        }
+        return;
+      }
+
+      boost::system::error_code error = ec;
+      std::size_t nReceived = 0;
+      if (!error) {
+        nReceived = receiveDatagrams(error);
+      }
+      if (error && !isWouldBlock(error)) {
+        close();
+        throw Error("error while receiving from the forwarder: " + error.message());
+      }
+
+      for (std::size_t i = 0; i < nReceived; i++) {
+        auto [isOk, element] = ndn::Block::fromBuffer(ndn::make_span(m_inputBuffers[i].data(), m_inputSizes[i]));
+        // like the forwarder, drop the datagrams that are not exactly one packet
+        if (isOk && element.size() == m_inputSizes[i]) {
+          m_receiveCallback(element);
+        }
+      }
+
+      if (m_isReceiving && !m_isReading) {
+        receive();
+      }
+    });
+  }
+
+  /**
+   * \brief Receives the datagrams waiting in the socket, up to RECEIVE_BATCH_SIZE.
+   */
+  std::size_t
+  receiveDatagrams(boost::system::error_code& ec)
+  {
+#ifdef __linux__
+    std::array<iovec, RECEIVE_BATCH_SIZE> iovecs;
+    std::array<mmsghdr, RECEIVE_BATCH_SIZE> headers{};
+    for (std::size_t i = 0; i < RECEIVE_BATCH_SIZE; i++) {
+      iovecs[i].iov_base = m_inputBuffers[i].data();
+      iovecs[i].iov_len = m_inputBuffers[i].size();
+      headers[i].msg_hdr.msg_iov = &iovecs[i];
+      headers[i].msg_hdr.msg_iovlen = 1;
+    }
+    int nReceived = ::recvmmsg(m_socket->native_handle(), headers.data(), RECEIVE_BATCH_SIZE, MSG_DONTWAIT, nullptr);
+    if (nReceived < 0) {
+      ec.assign(errno, boost::system::system_category());
+      return 0;
+    }
+    for (int i = 0; i < nReceived; i++) {
+      m_inputSizes[i] = headers[i].msg_len;
+    }
+    return static_cast<std::size_t>(nReceived);
+#else
+    m_inputSizes[0] = m_socket->receive(boost::asio::buffer(m_inputBuffers[0]), 0, ec);
+    return ec ? 0 : 1;
+#endif
+  }
+
+private:
+  static constexpr std::size_t RECEIVE_BATCH_SIZE = 16;
+
+  Protocol::endpoint m_endpoint;
+  const bool m_wantFixedPort;
+  std::optional<Protocol::socket> m_socket;
+  std::size_t m_nSent = 0; ///< packets of m_batch already sent
+#ifdef __linux__
+  std::vector<iovec> m_iovecs;
+  std::vector<mmsghdr> m_headers;
+#endif
+  std::array<std::array<uint8_t, ndn::MAX_NDN_PACKET_SIZE>, RECEIVE_BATCH_SIZE> m_inputBuffers;
+  std::array<std::size_t, RECEIVE_BATCH_SIZE> m_inputSizes{};
+  bool m_isReading = false;
+};
+
+inline std::string
+BatchingTransport::getDefaultUri()
+{
+  std::string uri;
+  if (const char* env = std::getenv("NDN_CLIENT_TRANSPORT"); env != nullptr) {
+    uri = env;
+  }
+  else {
+    try {
+      uri = ndn::ConfigFile().getParsedConfiguration().get<std::string>("transport", "");
+    }
+    catch (const ndn::ConfigFile::Error& e) {
+      throw Error(e.what());
+    }
+  }
+  if (uri.empty() || uri == "unix://") {
+    // same default as ndn-cxx
+#ifdef __linux__
+    uri = "unix:///run/nfd/nfd.sock";
+#else
+    uri = "unix:///var/run/nfd/nfd.sock";
+#endif
+  }
+  return uri;
+}
+
+inline std::shared_ptr<BatchingTransport>
+BatchingTransport::create(const std::string& uri, const BatchPolicy& policy, bool wantFixedPort)
+{
+  std::optional<ndn::FaceUri> faceUri;
+  try {
+    faceUri.emplace(uri);
+  }
+  catch (const ndn::FaceUri::Error&) {
+    throw Error("'" + uri + "' is not a valid transport");
+  }
+
+  const auto& scheme = faceUri->getScheme();
+  if (scheme == "unix") {
+    using Protocol = boost::asio::local::stream_protocol;
+    return std::make_shared<BatchingStreamTransport<Protocol>>(Protocol::endpoint(faceUri->getPath()), policy);
+  }
+  auto resolve = [&] (auto protocol) {
+    using Protocol = decltype(protocol);
+    auto port = faceUri->getPort().empty() ? "6363" : faceUri->getPort();
+    try {
+      boost::asio::io_context io;
+      typename Protocol::resolver resolver(io);
+      auto results = scheme.back() == '4' ? resolver.resolve(Protocol::v4(), faceUri->getHost(), port) :
+                     scheme.back() == '6' ? resolver.resolve(Protocol::v6(), faceUri->getHost(), port) :
+                                            resolver.resolve(faceUri->getHost(), port);
+      return results.begin()->endpoint();
+    }
+    catch (const boost::system::system_error& e) {
+      throw Error("cannot resolve " + uri + ": " + e.what());
+    }
+  };
+  if (scheme == "tcp" || scheme == "tcp4" || scheme == "tcp6") {
+    using Protocol = boost::asio::ip::tcp;
+    return std::make_shared<BatchingStreamTransport<Protocol>>(resolve(Protocol::v4()), policy);
+  }
+  if (scheme == "udp" || scheme == "udp4" || scheme == "udp6") {
+    using Protocol = boost::asio::ip::udp;
+    return std::make_shared<BatchingDatagramTransport>(resolve(Protocol::v4()), policy, wantFixedPort);
+  }
+  throw Error("transport '" + uri + "' is not supported, only unix, tcp, and udp are");
+}
+
+/**
+ * \brief How the client and the server connect to the forwarder: `--transport`,
+ *        `--batch-size`, and `--batch-delay-us`.
+ */
+class TransportOptions
+{
+public:
+  using FaceFactory = std::function<std::unique_ptr<ndn::Face>(boost::asio::io_context& io)>;
+
+  static void
+  addCommandLineOptions(boost::program_options::options_description& options)
+  {
+    namespace po = boost::program_options;
+    options.add_options()
+      ("transport", po::value<std::string>(),
+                    "connect to the forwarder at this FaceUri (unix://PATH, tcp4://HOST:PORT, or "
+                    "udp4://HOST:PORT) instead of the one configured for ndn-cxx")
+      ("batch-size", po::value<int64_t>()->default_value(1),
+                    "write up to this many packets to the forwarder at once; 1 disables batching")
+      ("batch-delay-us", po::value<int64_t>()->default_value(0),
+                    "wait at most this many microseconds for a batch to fill up; with 0, a batch is "
+                    "written once the event loop has nothing else to do")
+      ;
+  }
+
+  /**
+   * \brief Reads the options added by addCommandLineOptions().
+   * \throw std::invalid_argument an argument is invalid; the message is meant for the user
+   */
+  static TransportOptions
+  fromCommandLine(const boost::program_options::variables_map& vm)
+  {
+    TransportOptions options;
+    if (vm.count("transport") > 0) {
+      options.m_uri = vm["transport"].as<std::string>();
+    }
+
+    auto batchSize = vm["batch-size"].as<int64_t>();
+    auto batchDelay = vm["batch-delay-us"].as<int64_t>();
+    if (batchSize <= 0) {
+      throw std::invalid_argument("the argument for option '--batch-size' must be positive");
+    }
+    if (batchDelay < 0) {
+      throw std::invalid_argument("the argument for option '--batch-delay-us' cannot be negative");
+    }
+    if (batchSize > 1) {
+      options.m_batchPolicy = BatchPolicy{static_cast<std::size_t>(batchSize), std::chrono::microseconds(batchDelay)};
+    }
+    else if (batchDelay > 0) {
+      throw std::invalid_argument("option '--batch-delay-us' requires a '--batch-size' greater than 1");
+    }
+    return options;
+  }
+
+  /**
+   * \brief Returns a factory of Faces that use a BatchingTransport as per these options, or
+   *        nullptr if the transport configured for ndn-cxx is good enough.
+   *
+   * One transport is created right away, so that an invalid or unresolvable FaceUri fails
+   * here rather than in a worker, which creates its own in the same way. The transport is
+   * not connected, so an unreachable endpoint still fails in the workers.
+   *
+   * \param socketBusyPoll SO_BUSY_POLL, which needs a BatchingTransport as well
+   * \param wantFixedPort see BatchingTransport::create()
+   * \param[out] isDatagram whether the transport is UDP, if not nullptr
+   * \throw std::exception
+   */
+  FaceFactory
+  makeFaceFactory(std::chrono::microseconds socketBusyPoll, bool wantFixedPort, bool* isDatagram = nullptr) const
+  {
+    if (!m_uri && !m_batchPolicy && socketBusyPoll == std::chrono::microseconds::zero()) {
+      return nullptr;
+    }
+    auto policy = m_batchPolicy.value_or(BatchPolicy{});
+    policy.m_socketBusyPoll = socketBusyPoll;
+    auto uri = m_uri ? *m_uri : BatchingTransport::getDefaultUri();
+    auto transport = BatchingTransport::create(uri, policy, wantFixedPort);
+    if (isDatagram != nullptr) {
+      *isDatagram = transport->isDatagram();
+    }
+    return [uri, policy, wantFixedPort] (auto& io) {
+      return std::make_unique<ndn::Face>(BatchingTransport::create(uri, policy, wantFixedPort), io);
+    };
+  }
+
+public:
+  std::optional<std::string> m_uri;
+  std::optional<BatchPolicy> m_batchPolicy; ///< with more than one packet per batch
+};
+
+/**
+ * \brief Returns the batching statistics of the Faces of all \p workers, a range of pointers
+ *        to objects that have an `m_face`.
+ */
+template<typename Workers>
+BatchStatistics
+getBatchStatistics(const Workers& workers)
+{
+  BatchStatistics stats;
+  for (const auto& worker : workers) {
+    auto transport = std::dynamic_pointer_cast<BatchingTransport>(worker->m_face->getTransport());
+    if (transport != nullptr) {
+      stats.merge(transport->getStatistics());
+    }
+  }
+  return stats;
+}
+
+} // namespace ndntg
+
+#endif // NDNTG_BATCHING_TRANSPORT_HPP
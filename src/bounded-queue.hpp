@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2023, Arizona Board of Regents.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NDNTG_BOUNDED_QUEUE_HPP
+#define NDNTG_BOUNDED_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <boost/core/noncopyable.hpp>
+
+namespace ndntg {
+
+/**
+ * \brief Lock-free bounded multi-producer multi-consumer queue.
+ *
+ * This is Dmitry Vyukov's array-based design: every cell carries a sequence number that
+ * tells producers and consumers whether it is free or filled for the current lap, so each
+ * operation costs a single compare-and-swap on the head or tail index in the common case.
+ * A full queue makes tryPush() fail instead of blocking.
+ */
+template<typename T>
+class BoundedQueue : boost::noncopyable
+{
+public:
+  /**
+   * \param capacity maximum number of elements, rounded up to a power of two
+   */
+  explicit
+  BoundedQueue(std::size_t capacity)
+  {
+    std::size_t size = 2;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    m_cells = std::make_unique<Cell[]>(size);
+    m_mask = size - 1;
+    for (std::size_t i = 0; i < size; i++) {
+      m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  bool
+  tryPush(T&& value)
+  {
+    auto pos = m_enqueuePos.load(std::memory_order_relaxed);
+    Cell* cell = nullptr;
+    while (true) {
+      cell = &m_cells[pos & m_mask];
+      auto seq = cell->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+      if (diff == 0) {
+        if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      }
+      else if (diff < 0) {
+        return false; // full
+      }
+      else {
+        pos = m_enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+
+    cell->value = std::move(value);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool
+  tryPop(T& value)
+  {
+    auto pos = m_dequeuePos.load(std::memory_order_relaxed);
+    Cell* cell = nullptr;
+    while (true) {
+      cell = &m_cells[pos & m_mask];
+      auto seq = cell->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      }
+      else if (diff < 0) {
+        return false; // empty
+      }
+      else {
+        pos = m_dequeuePos.load(std::memory_order_relaxed);
+      }
+    }
+
+    value = std::move(cell->value);
+    cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  struct Cell
+  {
+    std::atomic<std::size_t> sequence;
+    T value;
+  };
+
+  std::unique_ptr<Cell[]> m_cells;
+  std::size_t m_mask = 0;
+  // keep producers and consumers on separate cache lines
+  alignas(64) std::atomic<std::size_t> m_enqueuePos{0};
+  alignas(64) std::atomic<std::size_t> m_dequeuePos{0};
+};
+
+} // namespace ndntg
+
+#endif // NDNTG_BOUNDED_QUEUE_HPP
@@ -0,0 +1,289 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2023, Arizona Board of Regents.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NDNTG_COORDINATOR_HPP
+#define NDNTG_COORDINATOR_HPP
+
+#include <chrono>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/core/noncopyable.hpp>
+
+namespace ndntg {
+
+/**
+ * \brief Controller/agent protocol, which lets several client processes run as one.
+ *
+ * An agent connects to the controller over TCP and waits. Once the expected number of
+ * agents have connected, the controller sends each of them its assignment, which includes
+ * a common start time on the system clock, and then waits for every agent to send back
+ * its results. Every message is a header line, `TYPE LENGTH`, followed by LENGTH bytes of
+ * body, so that bodies can hold any text, such as a whole configuration file.
+ */
+namespace coordination {
+
+class Message
+{
+public:
+  std::string m_type;
+  std::string m_body;
+};
+
+/**
+ * \brief Sends and receives messages on one TCP connection.
+ */
+class Connection : boost::noncopyable
+{
+public:
+  using ReceiveHandler = std::function<void(const boost::system::error_code& ec, Message message)>;
+  using SendHandler = std::function<void(const boost::system::error_code& ec)>;
+
+  explicit
+  Connection(boost::asio::ip::tcp::socket socket)
+    : m_socket(std::move(socket))
+  {
+  }
+
+  boost::asio::ip::tcp::socket&
+  getSocket()
+  {
+    return m_socket;
+  }
+
+  void
+  asyncReceive(ReceiveHandler handler)
+  {
+    boost::asio::async_read_until(m_socket, m_buffer, '\n',
+      [this, handler = std::move(handler)] (const boost::system::error_code& ec, std::size_t) mutable {
+        if (ec) {
+          handler(ec, {});
+          return;
+        }
+        std::istream is(&m_buffer);
+        std::string header;
+        std::getline(is, header);
+        auto space = header.find(' ');
+        std::size_t length = 0;
+        try {
+          length = std::stoul(header.substr(space == std::string::npos ? header.size() : space + 1));
+        }
+        catch (const std::exception&) {
+          handler(boost::asio::error::invalid_argument, {});
+          return;
+        }
+        if (space == std::string::npos || length > MAX_MESSAGE_SIZE) {
+          handler(boost::asio::error::invalid_argument, {});
+          return;
+        }
+
+        auto type = header.substr(0, space);
+        auto nMissing = length > m_buffer.size() ? length - m_buffer.size() : 0;
+        boost::asio::async_read(m_socket, m_buffer, boost::asio::transfer_exactly(nMissing),
+          [this, type, length, handler = std::move(handler)] (const boost::system::error_code& ec, std::size_t) {
+            if (ec) {
+              handler(ec, {});
+              return;
+            }
+            std::string body(length, '\0');
+            std::istream(&m_buffer).read(body.data(), static_cast<std::streamsize>(length));
+            handler({}, {type, std::move(body)});
+          });
+      });
+  }
+
+  void
+  asyncSend(const Message& message, SendHandler handler)
+  {
+    m_outgoing = encode(message);
+    boost::asio::async_write(m_socket, boost::asio::buffer(m_outgoing),
+      [handler = std::move(handler)] (const boost::system::error_code& ec, std::size_t) {
+        handler(ec);
+      });
+  }
+
+  /**
+   * \brief Sends \p message, blocking until it has been written.
+   * \throw boost::system::system_error
+   */
+  void
+  send(const Message& message)
+  {
+    boost::asio::write(m_socket, boost::asio::buffer(encode(message)));
+  }
+
+  void
+  close()
+  {
+    boost::system::error_code ec;
+    m_socket.close(ec);
+  }
+
+private:
+  static std::string
+  encode(const Message& message)
+  {
+    return message.m_type + ' ' + std::to_string(message.m_body.size()) + '\n' + message.m_body;
+  }
+
+private:
+  /// a configuration file or the statistics of many patterns, but not an arbitrary stream
+  static constexpr std::size_t MAX_MESSAGE_SIZE = 64 * 1024 * 1024;
+
+  boost::asio::ip::tcp::socket m_socket;
+  boost::asio::streambuf m_buffer;
+  std::string m_outgoing;
+};
+
+/**
+ * \brief Waits for a given number of agents, sends them their assignments, and collects
+ *        one result message from each of them.
+ *
+ * The controller runs on the caller's io_context. The start time passed to the assignment
+ * maker leaves START_DELAY for the assignments to be delivered and for the agents to set up
+ * their faces, so that every agent can start to send at the same instant.
+ */
+class Controller : boost::noncopyable
+{
+public:
+  static constexpr std::chrono::seconds START_DELAY{3};
+
+  using Clock = std::chrono::system_clock;
+  using AssignmentMaker = std::function<std::vector<Message>(std::size_t agentId, Clock::time_point startTime)>;
+  using ConnectHandler = std::function<void(std::size_t agentId, const boost::asio::ip::tcp::endpoint& remote)>;
+  using CompletionHandler = std::function<void(const std::string& error, std::vector<Message> results)>;
+
+  /**
+   * \throw boost::system::system_error the endpoint cannot be bound
+   */
+  Controller(boost::asio::io_context& io, const boost::asio::ip::tcp::endpoint& endpoint, std::size_t nAgents,
+             AssignmentMaker makeAssignment, ConnectHandler onConnect, CompletionHandler onCompletion)
+    : m_acceptor(io, endpoint)
+    , m_nAgents(nAgents)
+    , m_makeAssignment(std::move(makeAssignment))
+    , m_onConnect(std::move(onConnect))
+    , m_onCompletion(std::move(onCompletion))
+    , m_results(nAgents)
+  {
+    accept();
+  }
+
+  void
+  close()
+  {
+    boost::system::error_code ec;
+    m_acceptor.close(ec);
+    for (auto& agent : m_agents) {
+      agent->close();
+    }
+  }
+
+private:
+  void
+  accept()
+  {
+    m_acceptor.async_accept([this] (const boost::system::error_code& ec, boost::asio::ip::tcp::socket socket) {
+      if (ec) {
+        return;
+      }
+      boost::system::error_code remoteError;
+      auto remote = socket.remote_endpoint(remoteError);
+      m_agents.push_back(std::make_unique<Connection>(std::move(socket)));
+      m_onConnect(m_agents.size() - 1, remote);
+      if (m_agents.size() < m_nAgents) {
+        accept();
+        return;
+      }
+
+      boost::system::error_code closeError;
+      m_acceptor.close(closeError);
+      auto startTime = Clock::now() + START_DELAY;
+      for (std::size_t agentId = 0; agentId < m_agents.size(); agentId++) {
+        sendAssignment(agentId, std::make_shared<std::vector<Message>>(m_makeAssignment(agentId, startTime)), 0);
+      }
+    });
+  }
+
+  void
+  sendAssignment(std::size_t agentId, std::shared_ptr<std::vector<Message>> messages, std::size_t index)
+  {
+    if (index == messages->size()) {
+      receiveResult(agentId);
+      return;
+    }
+    m_agents[agentId]->asyncSend((*messages)[index], [=] (const boost::system::error_code& ec) {
+      if (ec) {
+        fail("cannot send the assignment of agent " + std::to_string(agentId + 1) + ": " + ec.message());
+        return;
+      }
+      sendAssignment(agentId, messages, index + 1);
+    });
+  }
+
+  void
+  receiveResult(std::size_t agentId)
+  {
+    m_agents[agentId]->asyncReceive([=] (const boost::system::error_code& ec, Message message) {
+      if (ec) {
+        fail("lost the connection to agent " + std::to_string(agentId + 1) + ": " + ec.message());
+        return;
+      }
+      m_results[agentId] = std::move(message);
+      if (++m_nResults == m_nAgents) {
+        close();
+        m_onCompletion("", std::move(m_results));
+      }
+    });
+  }
+
+  void
+  fail(const std::string& error)
+  {
+    if (m_hasFailed) {
+      return;
+    }
+    m_hasFailed = true;
+    close();
+    m_onCompletion(error, {});
+  }
+
+private:
+  boost::asio::ip::tcp::acceptor m_acceptor;
+  const std::size_t m_nAgents;
+  AssignmentMaker m_makeAssignment;
+  ConnectHandler m_onConnect;
+  CompletionHandler m_onCompletion;
+  std::vector<std::unique_ptr<Connection>> m_agents;
+  std::vector<Message> m_results;
+  std::size_t m_nResults = 0;
+  bool m_hasFailed = false;
+};
+
+} // namespace coordination
+} // namespace ndntg
+
+#endif // NDNTG_COORDINATOR_HPP
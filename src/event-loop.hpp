@@ -0,0 +1,239 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2023, Arizona Board of Regents.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NDNTG_EVENT_LOOP_HPP
+#define NDNTG_EVENT_LOOP_HPP
+
+#include <ndn-cxx/face.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/variables_map.hpp>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ndntg {
+
+/**
+ * \brief Parses a list of CPUs such as `0-3,8`, in the format of taskset(1) and of
+ *        /sys/devices/system/cpu/online.
+ * \throw std::invalid_argument
+ */
+inline std::vector<unsigned>
+parseCpuList(const std::string& input)
+{
+  std::vector<unsigned> cpus;
+  std::size_t start = 0;
+  while (start <= input.size()) {
+    auto end = input.find(',', start);
+    auto range = input.substr(start, end == std::string::npos ? std::string::npos : end - start);
+    auto dash = range.find('-');
+    std::size_t first = 0;
+    std::size_t last = 0;
+    try {
+      std::size_t nParsed = 0;
+      first = last = std::stoul(range, &nParsed);
+      if (dash != std::string::npos) {
+        if (nParsed != dash) {
+          throw std::invalid_argument(range);
+        }
+        last = std::stoul(range.substr(dash + 1), &nParsed);
+        nParsed += dash + 1;
+      }
+      if (nParsed != range.size() || first > last) {
+        throw std::invalid_argument(range);
+      }
+#ifdef __linux__
+      if (last >= CPU_SETSIZE) {
+        throw std::invalid_argument(range);
+      }
+#endif
+    }
+    catch (const std::exception&) {
+      throw std::invalid_argument("'" + input + "' is not a valid list of CPUs");
+    }
+    for (auto cpu = first; cpu <= last; cpu++) {
+      cpus.push_back(static_cast<unsigned>(cpu));
+    }
+    if (end == std::string::npos) {
+      break;
+    }
+    start = end + 1;
+  }
+  return cpus;
+}
+
+/**
+ * \brief Binds the calling thread to \p cpu.
+ *
+ * With the default memory policy of Linux, the pages that the thread touches first from then on
+ * are allocated on the NUMA node of \p cpu, so state that should be local to the thread must be
+ * allocated after this call, on the thread itself.
+ *
+ * \return the NUMA node of \p cpu, if known
+ * \throw std::runtime_error
+ */
+inline std::optional<unsigned>
+bindThreadToCpu(unsigned cpu)
+{
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  int error = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+  if (error != 0) {
+    throw std::runtime_error("cannot bind a thread to CPU " + std::to_string(cpu) + ": " + std::strerror(error));
+  }
+
+  // the thread is migrated before pthread_setaffinity_np() returns
+  unsigned currentCpu = 0;
+  unsigned node = 0;
+  if (::syscall(SYS_getcpu, &currentCpu, &node, nullptr) != 0) {
+    return std::nullopt;
+  }
+  return node;
+#else
+  throw std::runtime_error("CPU affinity is not supported on this platform");
+#endif
+}
+
+/**
+ * \brief Runs the event loop of \p face until it has no work left, like Face::processEvents().
+ *
+ * If \p wantBusyPoll, the loop polls the io_context of \p face continuously instead of sleeping
+ * in epoll_wait() when there is nothing to do: it keeps one CPU busy, but saves the wakeup
+ * latency of every packet.
+ */
+inline void
+runEventLoop(ndn::Face& face, bool wantBusyPoll)
+{
+  if (!wantBusyPoll) {
+    face.processEvents();
+    return;
+  }
+
+  // with a negative timeout, processEvents() only runs the handlers that are ready; like run(),
+  // poll() stops the io_context once there is no work left
+  auto& io = face.getIoContext();
+  do {
+    face.processEvents(ndn::time::milliseconds(-1));
+  } while (!io.stopped());
+}
+
+/**
+ * \brief How the worker threads of the client and the server run: `--cpu-affinity`,
+ *        `--busy-poll`, and `--socket-busy-poll-us`.
+ */
+class EventLoopOptions
+{
+public:
+  static void
+  addCommandLineOptions(boost::program_options::options_description& options)
+  {
+    namespace po = boost::program_options;
+    options.add_options()
+      ("cpu-affinity", po::value<std::string>(),
+                       "bind the worker threads to these CPUs, e.g. 0-3,8, in turn, and allocate their state "
+                       "on the NUMA node of their CPU")
+      ("busy-poll", po::bool_switch(),
+                       "poll the event loop of each worker continuously instead of sleeping when idle; this "
+                       "keeps one CPU per worker busy, but lowers and stabilizes the latency")
+      ("socket-busy-poll-us", po::value<int64_t>(),
+                       "set SO_BUSY_POLL on the socket of each worker to this many microseconds (Linux only)")
+      ;
+  }
+
+  /**
+   * \brief Reads the options added by addCommandLineOptions().
+   * \throw std::invalid_argument an argument is invalid; the message is meant for the user
+   */
+  static EventLoopOptions
+  fromCommandLine(const boost::program_options::variables_map& vm)
+  {
+    EventLoopOptions options;
+    if (vm.count("cpu-affinity") > 0) {
+      try {
+        options.m_cpus = parseCpuList(vm["cpu-affinity"].as<std::string>());
+      }
+      catch (const std::invalid_argument&) {
+        throw std::invalid_argument("invalid argument for option '--cpu-affinity'");
+      }
+    }
+
+    options.m_wantBusyPoll = vm["busy-poll"].as<bool>();
+
+    if (vm.count("socket-busy-poll-us") > 0) {
+      auto duration = vm["socket-busy-poll-us"].as<int64_t>();
+      if (duration <= 0 || duration > 1000000) {
+        throw std::invalid_argument("the argument for option '--socket-busy-poll-us' must be between 1 and 1000000");
+      }
+      options.m_socketBusyPoll = std::chrono::microseconds(duration);
+    }
+    return options;
+  }
+
+  /**
+   * \brief Binds the calling thread, which runs worker \p workerId, to CPU
+   *        `m_cpus[workerId % m_cpus.size()]`.
+   *
+   * The caller should then reallocate the state that the worker uses on every packet, see
+   * bindThreadToCpu().
+   *
+   * \return where the worker runs, e.g. "CPU 3 (NUMA node 0)", or nullopt without `--cpu-affinity`
+   * \throw std::runtime_error
+   */
+  std::optional<std::string>
+  placeWorker(std::size_t workerId) const
+  {
+    if (m_cpus.empty()) {
+      return std::nullopt;
+    }
+    auto cpu = m_cpus[workerId % m_cpus.size()];
+    auto node = bindThreadToCpu(cpu);
+    return "CPU " + std::to_string(cpu) + (node ? " (NUMA node " + std::to_string(*node) + ")" : "");
+  }
+
+  /**
+   * \brief Runs the event loop of a worker, see runEventLoop().
+   */
+  void
+  run(ndn::Face& face) const
+  {
+    runEventLoop(face, m_wantBusyPoll);
+  }
+
+public:
+  std::vector<unsigned> m_cpus; ///< empty: no affinity
+  bool m_wantBusyPoll = false;
+  std::chrono::microseconds m_socketBusyPoll{0}; ///< zero: SO_BUSY_POLL is not set
+};
+
+} // namespace ndntg
+
+#endif // NDNTG_EVENT_LOOP_HPP
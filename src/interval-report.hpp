@@ -0,0 +1,129 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2023, Arizona Board of Regents.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NDNTG_INTERVAL_REPORT_HPP
+#define NDNTG_INTERVAL_REPORT_HPP
+
+#include "logger.hpp"
+
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ndntg {
+
+/**
+ * \brief Prints the periodic statistics requested with `--report-interval`.
+ *
+ * Every report is a single line, either in the usual log format (`Name=Value, ...`),
+ * as a JSON object, or as CSV, in which case a header line precedes the first report.
+ */
+class IntervalReporter
+{
+public:
+  enum class Format {
+    TEXT,
+    JSON,
+    CSV,
+  };
+
+  using Fields = std::vector<std::pair<std::string, double>>;
+
+  /**
+   * \throw std::invalid_argument the string is not one of "text", "json", "csv"
+   */
+  static Format
+  parseFormat(const std::string& input)
+  {
+    if (input == "text") {
+      return Format::TEXT;
+    }
+    if (input == "json") {
+      return Format::JSON;
+    }
+    if (input == "csv") {
+      return Format::CSV;
+    }
+    throw std::invalid_argument("'" + input + "' is not a valid report format");
+  }
+
+  explicit
+  IntervalReporter(Format format = Format::TEXT)
+    : m_format(format)
+  {
+  }
+
+  void
+  report(Logger& logger, const Fields& fields)
+  {
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(3);
+
+    switch (m_format) {
+      case Format::TEXT: {
+        os << "Interval Report    - ";
+        const char* sep = "";
+        for (const auto& [name, value] : fields) {
+          os << sep << name << '=' << value;
+          sep = ", ";
+        }
+        logger.log(os.str(), true, true);
+        return;
+      }
+      case Format::JSON: {
+        os << '{';
+        const char* sep = "";
+        for (const auto& [name, value] : fields) {
+          os << sep << '"' << name << "\":" << value;
+          sep = ",";
+        }
+        os << '}';
+        logger.log(os.str(), false, true);
+        return;
+      }
+      case Format::CSV: {
+        if (!m_hasPrintedHeader) {
+          std::string header;
+          for (const auto& field : fields) {
+            header += (header.empty() ? "" : ",") + field.first;
+          }
+          logger.log(header, false, true);
+          m_hasPrintedHeader = true;
+        }
+        const char* sep = "";
+        for (const auto& field : fields) {
+          os << sep << field.second;
+          sep = ",";
+        }
+        logger.log(os.str(), false, true);
+        return;
+      }
+    }
+  }
+
+private:
+  Format m_format;
+  bool m_hasPrintedHeader = false;
+};
+
+} // namespace ndntg
+
+#endif // NDNTG_INTERVAL_REPORT_HPP
@@ -0,0 +1,221 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2023, Arizona Board of Regents.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NDNTG_LATENCY_HISTOGRAM_HPP
+#define NDNTG_LATENCY_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ndntg {
+
+/**
+ * \brief Log-linear histogram of latencies, in the style of HdrHistogram.
+ *
+ * Values below 128 are counted exactly. Larger values fall into one of 64 linear
+ * sub-buckets per power of two, which bounds the relative error of any reported
+ * percentile to about 1.6%. The buckets are a fixed-size array of about 20 KB, so recording
+ * is O(1); values beyond the highest bucket (about 4.9 hours in nanoseconds) are counted in it.
+ *
+ * The array is only allocated by the first sample, so that the many histograms that never
+ * get one, such as those of idle patterns and of statistics snapshots, cost almost nothing
+ * to keep and to copy.
+ */
+class LatencyHistogram
+{
+public:
+  void
+  record(uint64_t value)
+  {
+    if (m_counts.empty()) {
+      m_counts.resize(N_BUCKETS);
+    }
+    m_counts[getIndex(value)]++;
+    m_count++;
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+  }
+
+  void
+  merge(const LatencyHistogram& other)
+  {
+    if (other.m_counts.empty()) {
+      return;
+    }
+    if (m_counts.empty()) {
+      m_counts.resize(N_BUCKETS);
+    }
+    for (std::size_t i = 0; i < N_BUCKETS; i++) {
+      m_counts[i] += other.m_counts[i];
+    }
+    m_count += other.m_count;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+  }
+
+  uint64_t
+  getCount() const
+  {
+    return m_count;
+  }
+
+  uint64_t
+  getMin() const
+  {
+    return m_count > 0 ? m_min : 0;
+  }
+
+  uint64_t
+  getMax() const
+  {
+    return m_max;
+  }
+
+  /**
+   * \brief Returns the value below which \p percentile percent of the samples fall.
+   *
+   * The result is the highest value of the bucket that contains the requested rank,
+   * but never more than the maximum recorded value.
+   */
+  uint64_t
+  getPercentile(double percentile) const
+  {
+    if (m_count == 0) {
+      return 0;
+    }
+
+    auto rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * m_count));
+    rank = std::clamp<uint64_t>(rank, 1, m_count);
+    uint64_t cumulative = 0;
+    for (std::size_t i = 0; i < m_counts.size(); i++) {
+      cumulative += m_counts[i];
+      if (cumulative >= rank) {
+        return std::min(getHighestValue(i), m_max);
+      }
+    }
+    return m_max;
+  }
+
+  /**
+   * \brief Encodes the histogram as one line of text, e.g. to merge it in another process.
+   *
+   * Only the non-empty buckets are listed, as `INDEX:COUNT`, after the count, minimum,
+   * and maximum.
+   */
+  std::string
+  toString() const
+  {
+    std::ostringstream os;
+    os << m_count << ' ' << m_min << ' ' << m_max;
+    for (std::size_t i = 0; i < m_counts.size(); i++) {
+      if (m_counts[i] > 0) {
+        os << ' ' << i << ':' << m_counts[i];
+      }
+    }
+    return os.str();
+  }
+
+  /**
+   * \brief Decodes the output of toString().
+   * \throw std::invalid_argument the string is not a valid histogram
+   */
+  static LatencyHistogram
+  fromString(const std::string& input)
+  {
+    LatencyHistogram histogram;
+    std::istringstream is(input);
+    if (!(is >> histogram.m_count >> histogram.m_min >> histogram.m_max)) {
+      throw std::invalid_argument("invalid histogram");
+    }
+
+    uint64_t total = 0;
+    std::size_t index = 0;
+    char colon = 0;
+    uint64_t count = 0;
+    while (is >> index >> colon >> count) {
+      if (index >= N_BUCKETS || colon != ':') {
+        throw std::invalid_argument("invalid histogram");
+      }
+      if (histogram.m_counts.empty()) {
+        histogram.m_counts.resize(N_BUCKETS);
+      }
+      histogram.m_counts[index] += count;
+      total += count;
+    }
+    if (!is.eof() || total != histogram.m_count) {
+      throw std::invalid_argument("invalid histogram");
+    }
+    return histogram;
+  }
+
+private:
+  static constexpr unsigned SUB_BUCKET_BITS = 7;
+  static constexpr uint64_t SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;     // 128
+  static constexpr uint64_t SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2;      // 64
+  static constexpr unsigned MAX_SHIFT = 37;                              // up to 2^44
+  static constexpr std::size_t N_BUCKETS = SUB_BUCKET_COUNT + MAX_SHIFT * SUB_BUCKET_HALF;
+
+  static std::size_t
+  getIndex(uint64_t value)
+  {
+    if (value < SUB_BUCKET_COUNT) {
+      return static_cast<std::size_t>(value);
+    }
+
+    unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(value));
+    unsigned shift = msb - (SUB_BUCKET_BITS - 1);
+    if (shift > MAX_SHIFT) {
+      return N_BUCKETS - 1;
+    }
+    // (value >> shift) is in [SUB_BUCKET_HALF, SUB_BUCKET_COUNT)
+    return static_cast<std::size_t>(SUB_BUCKET_COUNT + (shift - 1) * SUB_BUCKET_HALF +
+                                    ((value >> shift) - SUB_BUCKET_HALF));
+  }
+
+  static uint64_t
+  getHighestValue(std::size_t index)
+  {
+    if (index < SUB_BUCKET_COUNT) {
+      return index;
+    }
+    if (index == N_BUCKETS - 1) {
+      return UINT64_MAX; // also holds all the out-of-range values
+    }
+
+    auto j = index - SUB_BUCKET_COUNT;
+    unsigned shift = static_cast<unsigned>(j / SUB_BUCKET_HALF) + 1;
+    uint64_t subBucket = j % SUB_BUCKET_HALF + SUB_BUCKET_HALF;
+    return ((subBucket + 1) << shift) - 1;
+  }
+
+private:
+  std::vector<uint64_t> m_counts; ///< empty, or N_BUCKETS counts
+  uint64_t m_count = 0;
+  uint64_t m_min = UINT64_MAX;
+  uint64_t m_max = 0;
+};
+
+} // namespace ndntg
+
+#endif // NDNTG_LATENCY_HISTOGRAM_HPP
@@ -21,12 +21,21 @@
 #ifndef NDNTG_LOGGER_HPP
 #define NDNTG_LOGGER_HPP
 
+#include "bounded-queue.hpp"
+
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
 #include <string_view>
+#include <thread>
 
 #include <boost/container/static_vector.hpp>
+#include <boost/date_time/c_local_time_adjustor.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
@@ -44,9 +53,35 @@ public:
   {
   }
 
+  ~Logger()
+  {
+    stopAsync();
+  }
+
   void
   log(std::string_view logLine, bool printTimestamp, bool printToConsole)
   {
+    if (m_queue != nullptr) {
+      Record record{std::string(logLine), {}, printTimestamp, printToConsole};
+      if (printTimestamp) {
+        record.m_time = ndn::time::system_clock::now();
+      }
+      if (m_queue->tryPush(std::move(record))) {
+        return;
+      }
+      if (!printToConsole) {
+        // per-packet lines are expendable, never make the caller wait for them
+        m_nDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      while (!m_queue->tryPush(std::move(record))) {
+        std::this_thread::yield();
+      }
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
     boost::container::static_vector<std::reference_wrapper<std::ostream>, 2> destinations;
     if (!m_logLocation.empty()) {
       destinations.emplace_back(m_logFile);
@@ -76,9 +111,47 @@ public:
     }
   }
 
+  /**
+   * \brief Switches to asynchronous operation.
+   *
+   * Log lines are then queued in a lock-free bounded queue, together with their capture time,
+   * and a background thread formats them and writes them out in large batches. When the queue
+   * is full, lines that would not be printed to the console are dropped and counted, while the
+   * others wait for room.
+   */
+  void
+  startAsync(std::size_t queueCapacity = 65536)
+  {
+    BOOST_ASSERT(m_queue == nullptr);
+    m_queue = std::make_unique<BoundedQueue<Record>>(queueCapacity);
+    m_isStopping = false;
+    m_thread = std::thread([this] { drainQueue(); });
+  }
+
+  /**
+   * \brief Writes out all queued lines and returns to synchronous operation.
+   */
+  void
+  stopAsync()
+  {
+    if (m_queue == nullptr) {
+      return;
+    }
+
+    m_isStopping = true;
+    m_thread.join();
+    m_queue.reset();
+
+    if (auto nDropped = m_nDropped.exchange(0); nDropped > 0) {
+      log("WARNING: " + std::to_string(nDropped) + " log lines were dropped because the log queue was full",
+          false, true);
+    }
+  }
+
   void
   initialize(const std::string& instanceId, const std::string& timestampFormat)
   {
+    m_timestampFormat = timestampFormat;
     m_wantUnixTime = timestampFormat.empty();
     if (!timestampFormat.empty()) {
       std::cout.imbue(std::locale(std::cout.getloc(),
@@ -126,11 +199,107 @@ public:
     }
   }
 
+private:
+  class Record
+  {
+  public:
+    std::string m_line;
+    ndn::time::system_clock::time_point m_time;
+    bool m_printTimestamp = false;
+    bool m_printToConsole = false;
+  };
+
+  std::string
+  formatTimestamp(const ndn::time::system_clock::time_point& time, std::ostringstream& formatter) const
+  {
+    using namespace ndn::time;
+    auto us = toUnixTimestamp<microseconds>(time).count();
+    if (m_wantUnixTime) {
+      return std::to_string(us / 1e6);
+    }
+
+    using boost::posix_time::ptime;
+    auto utc = ptime(boost::gregorian::date(1970, 1, 1)) + boost::posix_time::microseconds(us);
+    formatter.str("");
+    formatter << boost::date_time::c_local_adjustor<ptime>::utc_to_local(utc);
+    return formatter.str();
+  }
+
+  void
+  drainQueue()
+  {
+    constexpr std::size_t FLUSH_THRESHOLD = 1 << 20;
+    constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(100);
+
+    std::ostringstream formatter;
+    if (!m_wantUnixTime) {
+      formatter.imbue(std::locale(formatter.getloc(),
+                                  new boost::posix_time::time_facet(m_timestampFormat.data())));
+    }
+
+    std::string fileBuffer;
+    std::string consoleBuffer;
+    auto write = [&] {
+      if (!fileBuffer.empty()) {
+        m_logFile.write(fileBuffer.data(), fileBuffer.size());
+        m_logFile.flush();
+        fileBuffer.clear();
+      }
+      if (!consoleBuffer.empty()) {
+        std::cout.write(consoleBuffer.data(), consoleBuffer.size());
+        std::cout.flush();
+        consoleBuffer.clear();
+      }
+    };
+
+    auto lastFlush = std::chrono::steady_clock::now();
+    Record record;
+    while (true) {
+      bool isStopping = m_isStopping.load();
+      bool hasPopped = false;
+      while (m_queue->tryPop(record)) {
+        hasPopped = true;
+        std::string prefix;
+        if (record.m_printTimestamp) {
+          prefix = '[' + formatTimestamp(record.m_time, formatter) + "] ";
+        }
+        if (!m_logLocation.empty()) {
+          fileBuffer.append(prefix).append(record.m_line).push_back('\n');
+        }
+        if (m_logLocation.empty() || record.m_printToConsole) {
+          consoleBuffer.append(prefix).append(record.m_line).push_back('\n');
+        }
+        if (fileBuffer.size() + consoleBuffer.size() >= FLUSH_THRESHOLD) {
+          write();
+        }
+      }
+
+      auto now = std::chrono::steady_clock::now();
+      if (isStopping || now - lastFlush >= FLUSH_INTERVAL) {
+        write();
+        lastFlush = now;
+      }
+      if (isStopping && !hasPopped) {
+        return;
+      }
+      if (!hasPopped) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+  }
+
 private:
   const std::string m_module;
   std::string m_logLocation;
+  std::string m_timestampFormat;
   std::ofstream m_logFile;
   bool m_wantUnixTime = true;
+  std::mutex m_mutex;
+
+  std::unique_ptr<BoundedQueue<Record>> m_queue;
+  std::thread m_thread;
+  std::atomic<bool> m_isStopping{false};
+  std::atomic<uint64_t> m_nDropped{0};
 };
 
 } // namespace ndntg
@@ -0,0 +1,187 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2023, Arizona Board of Regents.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NDNTG_MEMORY_USAGE_HPP
+#define NDNTG_MEMORY_USAGE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/core/noncopyable.hpp>
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/variables_map.hpp>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace ndntg {
+
+/**
+ * \brief Returns the resident set size of this process, in bytes, or 0 if it is unknown.
+ *
+ * This reads /proc/self/statm, which takes a few microseconds, so it is meant to be called
+ * periodically rather than on the packet processing path.
+ */
+inline uint64_t
+getResidentMemory()
+{
+  std::FILE* file = std::fopen("/proc/self/statm", "r");
+  if (file == nullptr) {
+    return 0;
+  }
+  unsigned long long size = 0;
+  unsigned long long resident = 0;
+  int n = std::fscanf(file, "%llu %llu", &size, &resident);
+  std::fclose(file);
+  if (n != 2) {
+    return 0;
+  }
+  return resident * static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+}
+
+/**
+ * \brief Returns the highest resident set size of this process so far, in bytes.
+ */
+inline uint64_t
+getPeakResidentMemory()
+{
+  struct rusage usage;
+  if (::getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#ifdef __APPLE__
+  return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+  // kilobytes everywhere else
+  return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+/**
+ * \brief Checks the resident memory every CHECK_INTERVAL, and reports when it is over `--memory-limit`.
+ *
+ * This makes a soak test fail with a clear error, rather than have the kernel kill
+ * the tool or the forwarder when the machine runs out of memory.
+ */
+class MemoryWatchdog : boost::noncopyable
+{
+public:
+  using ExceededHandler = std::function<void(const std::string& error)>;
+
+  explicit
+  MemoryWatchdog(boost::asio::io_context& io)
+    : m_timer(io)
+  {
+  }
+
+  static void
+  addCommandLineOptions(boost::program_options::options_description& options)
+  {
+    options.add_options()
+      ("memory-limit", boost::program_options::value<double>(),
+                       "exit with an error once the resident memory exceeds this many MiB")
+      ;
+  }
+
+  /**
+   * \brief Reads the option added by addCommandLineOptions().
+   * \return the limit in bytes, if any
+   * \throw std::invalid_argument the argument is invalid; the message is meant for the user
+   */
+  static std::optional<uint64_t>
+  fromCommandLine(const boost::program_options::variables_map& vm)
+  {
+    if (vm.count("memory-limit") == 0) {
+      return std::nullopt;
+    }
+    auto limit = vm["memory-limit"].as<double>();
+    if (!(limit > 0) || !std::isfinite(limit)) {
+      throw std::invalid_argument("the argument for option '--memory-limit' must be positive");
+    }
+    return std::max<uint64_t>(1, static_cast<uint64_t>(limit * 1048576));
+  }
+
+  /**
+   * \param limit in bytes
+   */
+  void
+  setLimit(uint64_t limit)
+  {
+    m_limit = limit;
+  }
+
+  /**
+   * \brief Starts checking, if a limit has been set.
+   *
+   * \p onExceeded is called once, on the io_context, and the checks stop.
+   */
+  void
+  start(ExceededHandler onExceeded)
+  {
+    if (!m_limit) {
+      return;
+    }
+    m_onExceeded = std::move(onExceeded);
+    scheduleCheck();
+  }
+
+  void
+  cancel()
+  {
+    m_timer.cancel();
+  }
+
+private:
+  void
+  scheduleCheck()
+  {
+    m_timer.expires_after(CHECK_INTERVAL);
+    m_timer.async_wait([this] (const boost::system::error_code& ec) {
+      if (ec) {
+        return;
+      }
+      auto resident = getResidentMemory();
+      if (resident > *m_limit) {
+        m_onExceeded("Resident memory of " + std::to_string(resident >> 20) +
+                     " MiB exceeds the limit of " + std::to_string(*m_limit >> 20) + " MiB");
+        return;
+      }
+      scheduleCheck();
+    });
+  }
+
+private:
+  static constexpr std::chrono::seconds CHECK_INTERVAL{1};
+
+  boost::asio::steady_timer m_timer;
+  std::optional<uint64_t> m_limit; ///< bytes
+  ExceededHandler m_onExceeded;
+};
+
+} // namespace ndntg
+
+#endif // NDNTG_MEMORY_USAGE_HPP
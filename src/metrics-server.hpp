@@ -0,0 +1,222 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2023, Arizona Board of Regents.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NDNTG_METRICS_SERVER_HPP
+#define NDNTG_METRICS_SERVER_HPP
+
+#include <algorithm>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/core/noncopyable.hpp>
+#include <boost/lexical_cast.hpp>
+
+namespace ndntg {
+
+/**
+ * \brief Minimal HTTP server answering `GET /metrics` in the Prometheus text format.
+ *
+ * The server runs on the caller's io_context. The metrics themselves are produced by a
+ * collector function, which may answer asynchronously, e.g. once every worker thread
+ * has reported its counters, so that a scrape never touches the packet path directly.
+ * Each connection serves a single request.
+ */
+class MetricsServer : boost::noncopyable
+{
+public:
+  using Reply = std::function<void(std::string body)>;
+  using Collector = std::function<void(Reply reply)>;
+
+  /**
+   * \brief Parses "HOST:PORT", "[IPV6]:PORT", or ":PORT" (all IPv4 addresses).
+   * \throw std::invalid_argument the string is not a valid endpoint
+   */
+  static boost::asio::ip::tcp::endpoint
+  parseEndpoint(const std::string& input)
+  {
+    auto colon = input.rfind(':');
+    if (colon == std::string::npos || colon + 1 == input.size()) {
+      throw std::invalid_argument("'" + input + "' is not a valid HOST:PORT");
+    }
+
+    auto host = input.substr(0, colon);
+    if (host.size() >= 2 && host.front() == '[' && host.back() == ']') {
+      host = host.substr(1, host.size() - 2);
+    }
+    try {
+      auto port = boost::lexical_cast<uint16_t>(input.substr(colon + 1));
+      if (host.empty()) {
+        return {boost::asio::ip::tcp::v4(), port};
+      }
+      return {boost::asio::ip::make_address(host), port};
+    }
+    catch (const std::exception&) {
+      throw std::invalid_argument("'" + input + "' is not a valid HOST:PORT");
+    }
+  }
+
+  /**
+   * \brief Escapes a label value for the Prometheus text format.
+   */
+  static std::string
+  escapeLabelValue(const std::string& value)
+  {
+    std::string escaped;
+    for (char c : value) {
+      switch (c) {
+        case '\\':
+          escaped += "\\\\";
+          break;
+        case '"':
+          escaped += "\\\"";
+          break;
+        case '\n':
+          escaped += "\\n";
+          break;
+        default:
+          escaped += c;
+          break;
+      }
+    }
+    return escaped;
+  }
+
+  /**
+   * \throw boost::system::system_error the endpoint cannot be bound
+   */
+  MetricsServer(boost::asio::io_context& io, const boost::asio::ip::tcp::endpoint& endpoint,
+                Collector collector)
+    : m_acceptor(io, endpoint)
+    , m_collector(std::move(collector))
+  {
+    accept();
+  }
+
+  /**
+   * \brief Stops accepting connections and drops the open ones.
+   */
+  void
+  close()
+  {
+    boost::system::error_code ec;
+    m_acceptor.close(ec);
+    for (const auto& weak : m_connections) {
+      if (auto connection = weak.lock(); connection != nullptr) {
+        connection->m_socket.close(ec);
+      }
+    }
+    m_connections.clear();
+  }
+
+private:
+  class Connection : public std::enable_shared_from_this<Connection>
+  {
+  public:
+    Connection(boost::asio::ip::tcp::socket socket, const Collector& collector)
+      : m_socket(std::move(socket))
+      , m_collector(collector)
+    {
+    }
+
+    void
+    start()
+    {
+      boost::asio::async_read_until(m_socket, m_request, "\r\n\r\n",
+        [self = shared_from_this()] (const boost::system::error_code& ec, std::size_t) {
+          if (!ec) {
+            self->onRequest();
+          }
+        });
+    }
+
+  private:
+    void
+    onRequest()
+    {
+      std::istream is(&m_request);
+      std::string method, target;
+      is >> method >> target;
+      if (method != "GET" || (target != "/metrics" && target.rfind("/metrics?", 0) != 0)) {
+        respond("404 Not Found", "not found\n");
+        return;
+      }
+      m_collector([self = shared_from_this()] (std::string body) {
+        self->respond("200 OK", std::move(body));
+      });
+    }
+
+    void
+    respond(const std::string& status, std::string body)
+    {
+      m_response = "HTTP/1.1 " + status + "\r\n"
+                   "Content-Type: text/plain; version=0.0.4\r\n"
+                   "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                   "Connection: close\r\n\r\n" + body;
+      boost::asio::async_write(m_socket, boost::asio::buffer(m_response),
+        [self = shared_from_this()] (const boost::system::error_code&, std::size_t) {
+          boost::system::error_code ec;
+          self->m_socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+          self->m_socket.close(ec);
+        });
+    }
+
+  public:
+    boost::asio::ip::tcp::socket m_socket;
+
+  private:
+    const Collector& m_collector;
+    boost::asio::streambuf m_request{8192};
+    std::string m_response;
+  };
+
+  void
+  accept()
+  {
+    m_acceptor.async_accept([this] (const boost::system::error_code& ec, boost::asio::ip::tcp::socket socket) {
+      if (ec) {
+        return;
+      }
+      auto connection = std::make_shared<Connection>(std::move(socket), m_collector);
+      // forget about the connections that are already gone
+      m_connections.erase(std::remove_if(m_connections.begin(), m_connections.end(),
+                                         [] (const auto& weak) { return weak.expired(); }),
+                          m_connections.end());
+      m_connections.push_back(connection);
+      connection->start();
+      accept();
+    });
+  }
+
+private:
+  boost::asio::ip::tcp::acceptor m_acceptor;
+  Collector m_collector;
+  std::vector<std::weak_ptr<Connection>> m_connections;
+};
+
+} // namespace ndntg
+
+#endif // NDNTG_METRICS_SERVER_HPP
@@ -0,0 +1,194 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2023, Arizona Board of Regents.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NDNTG_NAME_DISTRIBUTION_HPP
+#define NDNTG_NAME_DISTRIBUTION_HPP
+
+#include "alias-table.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/algorithm/string/split.hpp>
+
+namespace ndntg {
+
+/**
+ * \brief Popularity of the names in a catalogue of N contents, numbered from 0 to N-1.
+ *
+ * The textual representation is one of:
+ *  - `uniform:N`: every content is equally popular
+ *  - `zipf:ALPHA:N`: the popularity of content k is proportional to 1/(k+1)^ALPHA
+ *  - `hotset:HOT:PERCENT:N`: the first HOT contents receive PERCENT percent of the requests,
+ *    the other N-HOT contents share the rest; both sets are uniform
+ *
+ * Every sample takes constant time: the Zipf distribution is turned into an AliasTable
+ * once, which is then shared by all copies of the distribution.
+ */
+class NameDistribution
+{
+public:
+  enum class Type {
+    UNIFORM,
+    ZIPF,
+    HOT_SET,
+  };
+
+  /**
+   * \throw std::invalid_argument the string is not a valid name distribution
+   */
+  static NameDistribution
+  parse(const std::string& input)
+  {
+    std::vector<std::string> tokens;
+    boost::algorithm::split(tokens, input, [] (char c) { return c == ':'; });
+
+    auto fail = [&input] {
+      throw std::invalid_argument("'" + input + "' is not a valid name distribution");
+    };
+    auto toNumber = [&] (const std::string& token) {
+      std::size_t pos = 0;
+      double d = 0.0;
+      try {
+        d = std::stod(token, &pos);
+      }
+      catch (const std::exception&) {
+        fail();
+      }
+      if (pos != token.size() || !(d >= 0) || !std::isfinite(d)) {
+        fail();
+      }
+      return d;
+    };
+    auto toCount = [&] (const std::string& token) {
+      auto d = toNumber(token);
+      if (d < 1 || d != std::floor(d) || d > MAX_CONTENTS) {
+        fail();
+      }
+      return static_cast<uint64_t>(d);
+    };
+
+    NameDistribution dist;
+    if (tokens[0] == "uniform" && tokens.size() == 2) {
+      dist.m_type = Type::UNIFORM;
+      dist.m_nContents = toCount(tokens[1]);
+    }
+    else if (tokens[0] == "zipf" && tokens.size() == 3) {
+      dist.m_type = Type::ZIPF;
+      dist.m_alpha = toNumber(tokens[1]);
+      dist.m_nContents = toCount(tokens[2]);
+
+      std::vector<double> weights(dist.m_nContents);
+      for (uint64_t k = 0; k < dist.m_nContents; k++) {
+        weights[k] = std::pow(static_cast<double>(k + 1), -dist.m_alpha);
+      }
+      dist.m_table = std::make_shared<const AliasTable>(weights);
+    }
+    else if (tokens[0] == "hotset" && tokens.size() == 4) {
+      dist.m_type = Type::HOT_SET;
+      dist.m_nHotContents = toCount(tokens[1]);
+      dist.m_hotPercentage = toNumber(tokens[2]);
+      dist.m_nContents = toCount(tokens[3]);
+      if (dist.m_nHotContents > dist.m_nContents || dist.m_hotPercentage > 100.0) {
+        fail();
+      }
+    }
+    else {
+      fail();
+    }
+    return dist;
+  }
+
+  Type
+  getType() const
+  {
+    return m_type;
+  }
+
+  /**
+   * \brief Returns the size N of the catalogue.
+   */
+  uint64_t
+  size() const
+  {
+    return m_nContents;
+  }
+
+  /**
+   * \brief Picks a content index in [0, size()).
+   */
+  template<typename RandomEngine>
+  uint64_t
+  sample(RandomEngine& rng) const
+  {
+    switch (m_type) {
+      case Type::UNIFORM:
+        break;
+      case Type::ZIPF:
+        return m_table->sample(rng).value_or(0);
+      case Type::HOT_SET: {
+        std::uniform_real_distribution<double> coin(0.0, 100.0);
+        bool isHot = m_nHotContents == m_nContents ||
+                     (m_nHotContents > 0 && coin(rng) < m_hotPercentage);
+        if (isHot) {
+          return std::uniform_int_distribution<uint64_t>(0, m_nHotContents - 1)(rng);
+        }
+        return std::uniform_int_distribution<uint64_t>(m_nHotContents, m_nContents - 1)(rng);
+      }
+    }
+    return std::uniform_int_distribution<uint64_t>(0, m_nContents - 1)(rng);
+  }
+
+  friend std::ostream&
+  operator<<(std::ostream& os, const NameDistribution& dist)
+  {
+    switch (dist.m_type) {
+      case Type::UNIFORM:
+        return os << "uniform:" << dist.m_nContents;
+      case Type::ZIPF:
+        return os << "zipf:" << dist.m_alpha << ':' << dist.m_nContents;
+      case Type::HOT_SET:
+        return os << "hotset:" << dist.m_nHotContents << ':' << dist.m_hotPercentage << ':' << dist.m_nContents;
+    }
+    return os;
+  }
+
+private:
+  NameDistribution() = default;
+
+private:
+  /// bound on N, so that a typo cannot make the catalogue exhaust the memory
+  static constexpr double MAX_CONTENTS = 1e7;
+
+  Type m_type = Type::UNIFORM;
+  uint64_t m_nContents = 1;
+  double m_alpha = 0.0;
+  uint64_t m_nHotContents = 0;
+  double m_hotPercentage = 0.0;
+  std::shared_ptr<const AliasTable> m_table; ///< Zipf only
+};
+
+} // namespace ndntg
+
+#endif // NDNTG_NAME_DISTRIBUTION_HPP
@@ -0,0 +1,283 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2023, Arizona Board of Regents.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "allocation-counter.hpp"
+#include "ndn-traffic-client.hpp"
+#include "ndn-traffic-server.hpp"
+#include "profiler.hpp"
+
+#include <ndn-cxx/util/dummy-client-face.hpp>
+
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/variables_map.hpp>
+
+namespace ndntg {
+
+/**
+ * \brief Connects the Face of one client worker to the Face of one server worker.
+ *
+ * Both sides are DummyClientFace instances: every packet sent by one side is posted to the
+ * io_context of the other side, so each tool keeps processing its packets on its own thread,
+ * as with a real forwarder, but without the cost of the forwarder and of the sockets.
+ * The server's prefix registrations are answered by its face itself.
+ */
+class LoopbackLink : boost::noncopyable
+{
+public:
+  std::unique_ptr<ndn::Face>
+  makeClientFace(boost::asio::io_context& io)
+  {
+    auto face = std::make_unique<ndn::DummyClientFace>(io, ndn::DummyClientFace::Options{false, false});
+    face->onSendInterest.connect([this] (const ndn::Interest& interest) {
+      boost::asio::post(*m_serverIo, [face = m_serverFace, interest] { face->receive(interest); });
+    });
+    m_clientIo = &io;
+    m_clientFace = face.get();
+    return face;
+  }
+
+  std::unique_ptr<ndn::Face>
+  makeServerFace(boost::asio::io_context& io)
+  {
+    auto face = std::make_unique<ndn::DummyClientFace>(io, ndn::DummyClientFace::Options{false, true});
+    face->onSendInterest.connect([this, &io] (const ndn::Interest& interest) {
+      static const ndn::Name registrationPrefix("/localhost/nfd/rib/register");
+      if (!registrationPrefix.isPrefixOf(interest.getName())) {
+        return;
+      }
+      // the face posts its reply to the command before this handler runs, so the prefix
+      // is registered once the task posted here has run
+      m_nPendingRegistrations++;
+      boost::asio::post(io, [this] {
+        if (--m_nPendingRegistrations == 0) {
+          notifyServer(true, false);
+        }
+      });
+    });
+    face->onSendData.connect([this] (const ndn::Data& data) {
+      m_nDataSent.fetch_add(1, std::memory_order_relaxed);
+      boost::asio::post(*m_clientIo, [face = m_clientFace, data] { face->receive(data); });
+    });
+    m_serverIo = &io;
+    m_serverFace = face.get();
+    return face;
+  }
+
+  /**
+   * \brief Blocks until the server has registered its prefixes or has exited.
+   * \return whether the server is ready
+   */
+  bool
+  waitForServer()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this] { return m_isServerReady || m_hasServerExited; });
+    return m_isServerReady && !m_hasServerExited;
+  }
+
+  void
+  notifyServer(bool isReady, bool hasExited)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_isServerReady = m_isServerReady || isReady;
+      m_hasServerExited = m_hasServerExited || hasExited;
+    }
+    m_cv.notify_all();
+  }
+
+  uint64_t
+  getDataSent() const
+  {
+    return m_nDataSent.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * \brief Makes the server's event loop return, for when it will never see enough Interests.
+   */
+  void
+  stopServer()
+  {
+    boost::asio::post(*m_serverIo, [face = m_serverFace, io = m_serverIo] {
+      face->shutdown();
+      io->stop();
+    });
+  }
+
+private:
+  boost::asio::io_context* m_clientIo = nullptr;
+  ndn::DummyClientFace* m_clientFace = nullptr;
+  boost::asio::io_context* m_serverIo = nullptr;
+  ndn::DummyClientFace* m_serverFace = nullptr;
+  std::size_t m_nPendingRegistrations = 0; ///< accessed on the server's thread only
+  std::atomic<uint64_t> m_nDataSent{0};
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  bool m_isServerReady = false;
+  bool m_hasServerExited = false;
+};
+
+/**
+ * \brief Runs \p client against \p server over a LoopbackLink and reports the achieved rate,
+ *        the allocations, and the profile of the packet processing functions.
+ */
+static int
+runBenchmark(NdnTrafficClient& client, NdnTrafficServer& server, uint64_t nInterests)
+{
+  LoopbackLink link;
+  client.setFaceFactory([&link] (auto& io) { return link.makeClientFace(io); });
+  server.setFaceFactory([&link] (auto& io) { return link.makeServerFace(io); });
+
+  int serverExitCode = 0;
+  uint64_t nServerAllocations = 0;
+  std::thread serverThread([&] {
+    auto nAllocations = g_nAllocations;
+    serverExitCode = server.run();
+    nServerAllocations = g_nAllocations - nAllocations;
+    link.notifyServer(false, true);
+  });
+
+  if (!link.waitForServer()) {
+    serverThread.join();
+    std::cerr << "ERROR: the server exited before registering its prefixes\n";
+    return serverExitCode != 0 ? serverExitCode : 1;
+  }
+
+  auto nClientAllocations = g_nAllocations;
+  auto startTime = std::chrono::steady_clock::now();
+  int clientExitCode = client.run();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+  nClientAllocations = g_nAllocations - nClientAllocations;
+
+  // with timeouts or a mismatched configuration, the server never reaches its --count
+  if (link.getDataSent() < nInterests) {
+    link.stopServer();
+  }
+  serverThread.join();
+
+  std::cout << "\n== Loopback Benchmark ==\n\n"
+            << "Interests                   = " << nInterests << "\n"
+            << "Elapsed Time                = " << elapsed.count() << "s\n"
+            << "Round Trips Per Second      = " << nInterests / elapsed.count() << "\n"
+            << "Client Allocations Per Op   = " << static_cast<double>(nClientAllocations) / nInterests << "\n"
+            << "Server Allocations Per Op   = " << static_cast<double>(nServerAllocations) / nInterests << "\n";
+
+  std::cout << "\n== Profile ==\n\n";
+  for (const auto* section : profile::Section::getAll()) {
+    auto nCalls = section->getCalls();
+    std::cout << "Section=" << section->getName()
+              << ", Calls=" << nCalls
+              << ", TotalTime=" << std::chrono::duration<double>(section->getTotalTime()).count() << "s"
+              << ", NsPerCall=" << (nCalls > 0 ? section->getTotalTime().count() / nCalls : 0) << "\n";
+  }
+
+  return clientExitCode != 0 ? clientExitCode : serverExitCode;
+}
+
+} // namespace ndntg
+
+namespace po = boost::program_options;
+
+static void
+usage(std::ostream& os, std::string_view programName, const po::options_description& desc)
+{
+  os << "Usage: " << programName << " [options] <Client_Configuration_File> <Server_Configuration_File>\n"
+     << "\n"
+     << "Run ndn-traffic-client and ndn-traffic-server in one process, connected by in-process faces\n"
+     << "instead of a forwarder, and report the rate that the two tools alone can sustain, as well as\n"
+     << "the time spent in prepareInterest, onInterest, and onData. Each tool runs one worker thread.\n"
+     << "\n"
+     << desc;
+}
+
+int
+main(int argc, char* argv[])
+{
+  std::string clientConfigFile;
+  std::string serverConfigFile;
+
+  po::options_description visibleOptions("Options");
+  visibleOptions.add_options()
+    ("help,h",   "print this help message and exit")
+    ("count,c",  po::value<int64_t>()->default_value(100000), "number of Interests to send")
+    ("window,w", po::value<int64_t>()->default_value(64), "number of outstanding Interests")
+    ;
+
+  po::options_description hiddenOptions;
+  hiddenOptions.add_options()
+    ("client-config-file", po::value<std::string>(&clientConfigFile))
+    ("server-config-file", po::value<std::string>(&serverConfigFile))
+    ;
+
+  po::positional_options_description posOptions;
+  posOptions.add("client-config-file", 1).add("server-config-file", 1);
+
+  po::options_description allOptions;
+  allOptions.add(visibleOptions).add(hiddenOptions);
+
+  po::variables_map vm;
+  try {
+    po::store(po::command_line_parser(argc, argv).options(allOptions).positional(posOptions).run(), vm);
+    po::notify(vm);
+  }
+  catch (const po::error& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 2;
+  }
+
+  if (vm.count("help") > 0) {
+    usage(std::cout, argv[0], visibleOptions);
+    return 0;
+  }
+
+  if (clientConfigFile.empty() || serverConfigFile.empty()) {
+    usage(std::cerr, argv[0], visibleOptions);
+    return 2;
+  }
+
+  auto count = vm["count"].as<int64_t>();
+  if (count <= 0) {
+    std::cerr << "ERROR: the argument for option '--count' must be positive\n";
+    return 2;
+  }
+
+  auto window = vm["window"].as<int64_t>();
+  if (window <= 0) {
+    std::cerr << "ERROR: the argument for option '--window' must be positive\n";
+    return 2;
+  }
+
+  ndntg::NdnTrafficClient client(std::move(clientConfigFile));
+  client.setMaximumInterests(static_cast<uint64_t>(count));
+  client.setInterestWindow(static_cast<std::size_t>(window), false);
+  client.setQuietLogging();
+  client.setBriefLogging();
+
+  ndntg::NdnTrafficServer server(std::move(serverConfigFile));
+  server.setMaximumInterests(static_cast<uint64_t>(count));
+  server.setQuietLogging();
+  server.setBriefLogging();
+
+  return ndntg::runBenchmark(client, server, static_cast<uint64_t>(count));
+}
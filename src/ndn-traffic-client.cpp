@@ -18,570 +18,25 @@
  * Author: Jerald Paul Abraham <jeraldabraham@email.arizona.edu>
  */
 
-#include "util.hpp"
-
-#include <ndn-cxx/data.hpp>
-#include <ndn-cxx/face.hpp>
-#include <ndn-cxx/interest.hpp>
-#include <ndn-cxx/lp/tags.hpp>
-#include <ndn-cxx/util/random.hpp>
-#include <ndn-cxx/util/time.hpp>
-
-#include <limits>
-#include <optional>
-#include <sstream>
-#include <vector>
-
-#include <boost/asio/deadline_timer.hpp>
-#include <boost/asio/io_context.hpp>
-#include <boost/asio/signal_set.hpp>
-#include <boost/core/noncopyable.hpp>
-#include <boost/date_time/posix_time/posix_time.hpp>
-#include <boost/lexical_cast.hpp>
+#include "ndn-traffic-client.hpp"
+
+#include <cmath>
+
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/parsers.hpp>
 #include <boost/program_options/variables_map.hpp>
 
-using namespace ndn::time_literals;
-using namespace std::string_literals;
-
-namespace ndntg {
-
-namespace time = ndn::time;
-
-class NdnTrafficClient : boost::noncopyable
-{
-public:
-  explicit
-  NdnTrafficClient(std::string configFile)
-    : m_configurationFile(std::move(configFile))
-  {
-  }
-
-  void
-  setMaximumInterests(uint64_t maxInterests)
-  {
-    m_nMaximumInterests = maxInterests;
-  }
-
-  void
-  setInterestInterval(time::milliseconds interval)
-  {
-    BOOST_ASSERT(interval > 0_ms);
-    m_interestInterval = interval;
-  }
-
-  void
-  setTimestampFormat(std::string format)
-  {
-    m_timestampFormat = std::move(format);
-  }
-
-  void
-  setQuietLogging()
-  {
-    m_wantQuiet = true;
-  }
-
-  void
-  setVerboseLogging()
-  {
-    m_wantVerbose = true;
-  }
-
-  int
-  run()
-  {
-    m_logger.initialize(std::to_string(ndn::random::generateWord32()), m_timestampFormat);
-
-    if (!readConfigurationFile(m_configurationFile, m_trafficPatterns, m_logger)) {
-      return 2;
-    }
-
-    if (!checkTrafficPatternCorrectness()) {
-      m_logger.log("ERROR: Traffic configuration provided is not proper", false, true);
-      return 2;
-    }
-
-    m_logger.log("Traffic configuration file processing completed\n", true, false);
-    for (std::size_t i = 0; i < m_trafficPatterns.size(); i++) {
-      m_logger.log("Traffic Pattern Type #" + std::to_string(i + 1), false, false);
-      m_trafficPatterns[i].printTrafficConfiguration(m_logger);
-      m_logger.log("", false, false);
-    }
-
-    if (m_nMaximumInterests == 0) {
-      logStatistics();
-      return 0;
-    }
-
-    m_signalSet.async_wait([this] (auto&&...) { stop(); });
-
-    boost::asio::deadline_timer timer(m_io, boost::posix_time::millisec(m_interestInterval.count()));
-    timer.async_wait([this, &timer] (auto&&...) { generateTraffic(timer); });
-
-    try {
-      m_face.processEvents();
-      return m_hasError ? 1 : 0;
-    }
-    catch (const std::exception& e) {
-      m_logger.log("ERROR: "s + e.what(), true, true);
-      m_io.stop();
-      return 1;
-    }
-  }
-
-private:
-  class InterestTrafficConfiguration
-  {
-  public:
-    void
-    printTrafficConfiguration(Logger& logger) const
-    {
-      std::ostringstream os;
-
-      os << "TrafficPercentage=" << m_trafficPercentage << ", ";
-      os << "Name=" << m_name << ", ";
-      if (m_nameAppendBytes) {
-        os << "NameAppendBytes=" << *m_nameAppendBytes << ", ";
-      }
-      if (m_nameAppendSeqNum) {
-        os << "NameAppendSequenceNumber=" << *m_nameAppendSeqNum << ", ";
-      }
-      if (m_canBePrefix) {
-        os << "CanBePrefix=" << m_canBePrefix << ", ";
-      }
-      if (m_mustBeFresh) {
-        os << "MustBeFresh=" << m_mustBeFresh << ", ";
-      }
-      if (m_nonceDuplicationPercentage > 0) {
-        os << "NonceDuplicationPercentage=" << m_nonceDuplicationPercentage << ", ";
-      }
-      if (m_interestLifetime >= 0_ms) {
-        os << "InterestLifetime=" << m_interestLifetime.count() << ", ";
-      }
-      if (m_nextHopFaceId > 0) {
-        os << "NextHopFaceId=" << m_nextHopFaceId << ", ";
-      }
-      if (m_expectedContent) {
-        os << "ExpectedContent=" << *m_expectedContent << ", ";
-      }
-
-      auto str = os.str();
-      str = str.substr(0, str.length() - 2); // remove suffix ", "
-      logger.log(str, false, false);
-    }
-
-    bool
-    parseConfigurationLine(const std::string& line, Logger& logger, int lineNumber)
-    {
-      std::string parameter, value;
-      if (!extractParameterAndValue(line, parameter, value)) {
-        logger.log("Line " + std::to_string(lineNumber) + " - Invalid syntax: " + line,
-                   false, true);
-        return false;
-      }
-
-      if (parameter == "TrafficPercentage") {
-        m_trafficPercentage = std::stod(value);
-        if (!std::isfinite(m_trafficPercentage)) {
-          logger.log("Line " + std::to_string(lineNumber) +
-                     " - TrafficPercentage must be a finite floating point value", false, true);
-          return false;
-        }
-      }
-      else if (parameter == "Name") {
-        m_name = value;
-      }
-      else if (parameter == "NameAppendBytes") {
-        m_nameAppendBytes = std::stoul(value);
-      }
-      else if (parameter == "NameAppendSequenceNumber") {
-        m_nameAppendSeqNum = std::stoull(value);
-      }
-      else if (parameter == "CanBePrefix") {
-        m_canBePrefix = parseBoolean(value);
-      }
-      else if (parameter == "MustBeFresh") {
-        m_mustBeFresh = parseBoolean(value);
-      }
-      else if (parameter == "NonceDuplicationPercentage") {
-        m_nonceDuplicationPercentage = std::stoul(value);
-      }
-      else if (parameter == "InterestLifetime") {
-        m_interestLifetime = time::milliseconds(std::stoul(value));
-      }
-      else if (parameter == "NextHopFaceId") {
-        m_nextHopFaceId = std::stoull(value);
-      }
-      else if (parameter == "ExpectedContent") {
-        m_expectedContent = value;
-      }
-      else {
-        logger.log("Line " + std::to_string(lineNumber) + " - Ignoring unknown parameter: " + parameter,
-                   false, true);
-      }
-      return true;
-    }
-
-    bool
-    checkTrafficDetailCorrectness() const
-    {
-      return true;
-    }
-
-  public:
-    double m_trafficPercentage = 0.0;
-    std::string m_name;
-    std::optional<std::size_t> m_nameAppendBytes;
-    std::optional<uint64_t> m_nameAppendSeqNum;
-    bool m_canBePrefix = false;
-    bool m_mustBeFresh = false;
-    unsigned m_nonceDuplicationPercentage = 0;
-    time::milliseconds m_interestLifetime = -1_ms;
-    uint64_t m_nextHopFaceId = 0;
-    std::optional<std::string> m_expectedContent;
-
-    uint64_t m_nInterestsSent = 0;
-    uint64_t m_nInterestsReceived = 0;
-    uint64_t m_nNacks = 0;
-    uint64_t m_nContentInconsistencies = 0;
-
-    // RTT is stored as milliseconds with fractional sub-milliseconds precision
-    double m_minimumInterestRoundTripTime = std::numeric_limits<double>::max();
-    double m_maximumInterestRoundTripTime = 0;
-    double m_totalInterestRoundTripTime = 0;
-  };
-
-  void
-  logStatistics()
-  {
-    using std::to_string;
-
-    m_logger.log("\n\n== Traffic Report ==\n", false, true);
-    m_logger.log("Total Traffic Pattern Types = " + to_string(m_trafficPatterns.size()), false, true);
-    m_logger.log("Total Interests Sent        = " + to_string(m_nInterestsSent), false, true);
-    m_logger.log("Total Responses Received    = " + to_string(m_nInterestsReceived), false, true);
-    m_logger.log("Total Nacks Received        = " + to_string(m_nNacks), false, true);
-
-    double loss = 0.0;
-    if (m_nInterestsSent > 0) {
-      loss = (m_nInterestsSent - m_nInterestsReceived) * 100.0 / m_nInterestsSent;
-    }
-    m_logger.log("Total Interest Loss         = " + to_string(loss) + "%", false, true);
-
-    double average = 0.0;
-    double inconsistency = 0.0;
-    if (m_nInterestsReceived > 0) {
-      average = m_totalInterestRoundTripTime / m_nInterestsReceived;
-      inconsistency = m_nContentInconsistencies * 100.0 / m_nInterestsReceived;
-    }
-    m_logger.log("Total Data Inconsistency    = " + to_string(inconsistency) + "%", false, true);
-    m_logger.log("Total Round Trip Time       = " + to_string(m_totalInterestRoundTripTime) + "ms", false, true);
-    m_logger.log("Average Round Trip Time     = " + to_string(average) + "ms\n", false, true);
-
-    for (std::size_t patternId = 0; patternId < m_trafficPatterns.size(); patternId++) {
-      const auto& pattern = m_trafficPatterns[patternId];
-
-      m_logger.log("Traffic Pattern Type #" + to_string(patternId + 1), false, true);
-      pattern.printTrafficConfiguration(m_logger);
-      m_logger.log("Total Interests Sent        = " + to_string(pattern.m_nInterestsSent), false, true);
-      m_logger.log("Total Responses Received    = " + to_string(pattern.m_nInterestsReceived), false, true);
-      m_logger.log("Total Nacks Received        = " + to_string(pattern.m_nNacks), false, true);
-
-      loss = 0.0;
-      if (pattern.m_nInterestsSent > 0) {
-        loss = (pattern.m_nInterestsSent - pattern.m_nInterestsReceived) * 100.0 / pattern.m_nInterestsSent;
-      }
-      m_logger.log("Total Interest Loss         = " + to_string(loss) + "%", false, true);
-
-      average = 0.0;
-      inconsistency = 0.0;
-      if (pattern.m_nInterestsReceived > 0) {
-        average = pattern.m_totalInterestRoundTripTime / pattern.m_nInterestsReceived;
-        inconsistency = pattern.m_nContentInconsistencies * 100.0 / pattern.m_nInterestsReceived;
-      }
-      m_logger.log("Total Data Inconsistency    = " + to_string(inconsistency) + "%", false, true);
-      m_logger.log("Total Round Trip Time       = " +
-                   to_string(pattern.m_totalInterestRoundTripTime) + "ms", false, true);
-      m_logger.log("Average Round Trip Time     = " + to_string(average) + "ms\n", false, true);
-    }
-  }
-
-  bool
-  checkTrafficPatternCorrectness() const
-  {
-    // TODO
-    return true;
-  }
-
-  uint32_t
-  getNewNonce()
-  {
-    if (m_nonces.size() >= 1000)
-      m_nonces.clear();
-
-    auto randomNonce = ndn::random::generateWord32();
-    while (std::find(m_nonces.begin(), m_nonces.end(), randomNonce) != m_nonces.end())
-      randomNonce = ndn::random::generateWord32();
-
-    m_nonces.push_back(randomNonce);
-    return randomNonce;
-  }
-
-  uint32_t
-  getOldNonce()
-  {
-    if (m_nonces.empty())
-      return getNewNonce();
-
-    std::uniform_int_distribution<std::size_t> dist(0, m_nonces.size() - 1);
-    return m_nonces[dist(ndn::random::getRandomNumberEngine())];
-  }
-
-  static auto
-  generateRandomNameComponent(std::size_t length)
-  {
-    // per ISO C++ std, cannot instantiate uniform_int_distribution with uint8_t
-    static std::uniform_int_distribution<unsigned> dist(std::numeric_limits<uint8_t>::min(),
-                                                        std::numeric_limits<uint8_t>::max());
-
-    ndn::Buffer buf(length);
-    for (std::size_t i = 0; i < length; i++) {
-      buf[i] = static_cast<uint8_t>(dist(ndn::random::getRandomNumberEngine()));
-    }
-    return ndn::name::Component(buf);
-  }
-
-  auto
-  prepareInterest(std::size_t patternId)
-  {
-    ndn::Interest interest;
-    auto& pattern = m_trafficPatterns[patternId];
-
-    ndn::Name name(pattern.m_name);
-    if (pattern.m_nameAppendBytes > 0) {
-      name.append(generateRandomNameComponent(*pattern.m_nameAppendBytes));
-    }
-    if (pattern.m_nameAppendSeqNum) {
-      auto seqNum = *pattern.m_nameAppendSeqNum;
-      name.appendSequenceNumber(seqNum);
-      pattern.m_nameAppendSeqNum = seqNum + 1;
-    }
-    interest.setName(name);
-
-    interest.setCanBePrefix(pattern.m_canBePrefix);
-    interest.setMustBeFresh(pattern.m_mustBeFresh);
-
-    static std::uniform_int_distribution<unsigned> duplicateNonceDist(1, 100);
-    if (duplicateNonceDist(ndn::random::getRandomNumberEngine()) <= pattern.m_nonceDuplicationPercentage)
-      interest.setNonce(getOldNonce());
-    else
-      interest.setNonce(getNewNonce());
-
-    if (pattern.m_interestLifetime >= 0_ms)
-      interest.setInterestLifetime(pattern.m_interestLifetime);
-
-    if (pattern.m_nextHopFaceId > 0)
-      interest.setTag(std::make_shared<ndn::lp::NextHopFaceIdTag>(pattern.m_nextHopFaceId));
-
-    return interest;
-  }
-
-  void
-  onData(const ndn::Interest&, const ndn::Data& data, int globalRef, int localRef,
-         std::size_t patternId, const time::steady_clock::time_point& sentTime)
-  {
-    auto now = time::steady_clock::now();
-    auto logLine = "Data Received      - PatternType=" + std::to_string(patternId + 1) +
-                   ", GlobalID=" + std::to_string(globalRef) +
-                   ", LocalID=" + std::to_string(localRef) +
-                   ", Name=" + data.getName().toUri();
-
-    m_nInterestsReceived++;
-    m_trafficPatterns[patternId].m_nInterestsReceived++;
-
-    if (m_trafficPatterns[patternId].m_expectedContent) {
-      std::string receivedContent = readString(data.getContent());
-      if (receivedContent != *m_trafficPatterns[patternId].m_expectedContent) {
-        m_nContentInconsistencies++;
-        m_trafficPatterns[patternId].m_nContentInconsistencies++;
-        logLine += ", IsConsistent=No";
-      }
-      else {
-        logLine += ", IsConsistent=Yes";
-      }
-    }
-    else {
-      logLine += ", IsConsistent=NotChecked";
-    }
-    if (!m_wantQuiet) {
-      m_logger.log(logLine, true, false);
-    }
-
-    double rtt = time::duration_cast<time::nanoseconds>(now - sentTime).count() / 1e6;
-    if (m_wantVerbose) {
-      auto rttLine = "RTT                - Name=" + data.getName().toUri() +
-                     ", RTT=" + std::to_string(rtt) + "ms";
-      m_logger.log(rttLine, true, false);
-    }
-    if (m_minimumInterestRoundTripTime > rtt)
-      m_minimumInterestRoundTripTime = rtt;
-    if (m_maximumInterestRoundTripTime < rtt)
-      m_maximumInterestRoundTripTime = rtt;
-    if (m_trafficPatterns[patternId].m_minimumInterestRoundTripTime > rtt)
-      m_trafficPatterns[patternId].m_minimumInterestRoundTripTime = rtt;
-    if (m_trafficPatterns[patternId].m_maximumInterestRoundTripTime < rtt)
-      m_trafficPatterns[patternId].m_maximumInterestRoundTripTime = rtt;
-    m_totalInterestRoundTripTime += rtt;
-    m_trafficPatterns[patternId].m_totalInterestRoundTripTime += rtt;
-
-    if (m_nMaximumInterests == globalRef) {
-      stop();
-    }
-  }
-
-  void
-  onNack(const ndn::Interest& interest, const ndn::lp::Nack& nack,
-         int globalRef, int localRef, std::size_t patternId)
-  {
-    auto logLine = "Interest Nack'd    - PatternType=" + std::to_string(patternId + 1) +
-                   ", GlobalID=" + std::to_string(globalRef) +
-                   ", LocalID=" + std::to_string(localRef) +
-                   ", Name=" + interest.getName().toUri() +
-                   ", NackReason=" + boost::lexical_cast<std::string>(nack.getReason());
-    m_logger.log(logLine, true, false);
-
-    m_nNacks++;
-    m_trafficPatterns[patternId].m_nNacks++;
-
-    if (m_nMaximumInterests == globalRef) {
-      stop();
-    }
-  }
-
-  void
-  onTimeout(const ndn::Interest& interest, int globalRef, int localRef, std::size_t patternId)
-  {
-    auto logLine = "Interest Timed Out - PatternType=" + std::to_string(patternId + 1) +
-                   ", GlobalID=" + std::to_string(globalRef) +
-                   ", LocalID=" + std::to_string(localRef) +
-                   ", Name=" + interest.getName().toUri();
-    m_logger.log(logLine, true, false);
-
-    if (m_nMaximumInterests == globalRef) {
-      stop();
-    }
-  }
-
-  void
-  generateTraffic(boost::asio::deadline_timer& timer)
-  {
-    if (m_nMaximumInterests && m_nInterestsSent >= *m_nMaximumInterests) {
-      return;
-    }
-
-    static std::uniform_real_distribution<> trafficDist(std::numeric_limits<double>::min(), 100.0);
-    double trafficKey = trafficDist(ndn::random::getRandomNumberEngine());
-
-    double cumulativePercentage = 0.0;
-    std::size_t patternId = 0;
-    for (; patternId < m_trafficPatterns.size(); patternId++) {
-      auto& pattern = m_trafficPatterns[patternId];
-      cumulativePercentage += pattern.m_trafficPercentage;
-      if (trafficKey <= cumulativePercentage) {
-        m_nInterestsSent++;
-        pattern.m_nInterestsSent++;
-        auto interest = prepareInterest(patternId);
-        try {
-          int globalRef = m_nInterestsSent;
-          int localRef = pattern.m_nInterestsSent;
-          m_face.expressInterest(interest,
-            [=, now = time::steady_clock::now()] (auto&&... args) {
-              onData(std::forward<decltype(args)>(args)..., globalRef, localRef, patternId, now);
-            },
-            [=] (auto&&... args) {
-              onNack(std::forward<decltype(args)>(args)..., globalRef, localRef, patternId);
-            },
-            [=] (auto&&... args) {
-              onTimeout(std::forward<decltype(args)>(args)..., globalRef, localRef, patternId);
-            });
-
-          if (!m_wantQuiet) {
-            auto logLine = "Sending Interest   - PatternType=" + std::to_string(patternId + 1) +
-                           ", GlobalID=" + std::to_string(m_nInterestsSent) +
-                           ", LocalID=" + std::to_string(pattern.m_nInterestsSent) +
-                           ", Name=" + interest.getName().toUri();
-            m_logger.log(logLine, true, false);
-          }
-
-          timer.expires_at(timer.expires_at() + boost::posix_time::millisec(m_interestInterval.count()));
-          timer.async_wait([this, &timer] (auto&&...) { generateTraffic(timer); });
-        }
-        catch (const std::exception& e) {
-          m_logger.log("ERROR: "s + e.what(), true, true);
-        }
-        break;
-      }
-    }
-
-    if (patternId == m_trafficPatterns.size()) {
-      timer.expires_at(timer.expires_at() + boost::posix_time::millisec(m_interestInterval.count()));
-      timer.async_wait([this, &timer] (auto&&...) { generateTraffic(timer); });
-    }
-  }
-
-  void
-  stop()
-  {
-    if (m_nContentInconsistencies > 0 || m_nInterestsSent != m_nInterestsReceived) {
-      m_hasError = true;
-    }
-
-    logStatistics();
-    m_face.shutdown();
-    m_io.stop();
-  }
-
-private:
-  Logger m_logger{"NdnTrafficClient"};
-  boost::asio::io_context m_io;
-  boost::asio::signal_set m_signalSet{m_io, SIGINT, SIGTERM};
-  ndn::Face m_face{m_io};
-
-  std::string m_configurationFile;
-  std::string m_timestampFormat;
-  std::optional<uint64_t> m_nMaximumInterests;
-  time::milliseconds m_interestInterval = 1_s;
-
-  std::vector<InterestTrafficConfiguration> m_trafficPatterns;
-  std::vector<uint32_t> m_nonces;
-  uint64_t m_nInterestsSent = 0;
-  uint64_t m_nInterestsReceived = 0;
-  uint64_t m_nNacks = 0;
-  uint64_t m_nContentInconsistencies = 0;
-
-  // RTT is stored as milliseconds with fractional sub-milliseconds precision
-  double m_minimumInterestRoundTripTime = std::numeric_limits<double>::max();
-  double m_maximumInterestRoundTripTime = 0;
-  double m_totalInterestRoundTripTime = 0;
-
-  bool m_wantQuiet = false;
-  bool m_wantVerbose = false;
-  bool m_hasError = false;
-};
-
-} // namespace ndntg
-
 namespace po = boost::program_options;
 
 static void
 usage(std::ostream& os, std::string_view programName, const po::options_description& desc)
 {
   os << "Usage: " << programName << " [options] <Traffic_Configuration_File>\n"
+     << "       " << programName << " [options] --controller HOST:PORT\n"
      << "\n"
      << "Generate Interest traffic as per provided Traffic_Configuration_File.\n"
      << "Interests are continuously generated unless a total number is specified.\n"
+     << "Send SIGHUP to re-read Traffic_Configuration_File without interrupting the traffic.\n"
      << "Set the environment variable NDN_TRAFFIC_LOGFOLDER to redirect output to a log file.\n"
      << "\n"
      << desc;
@@ -597,11 +52,52 @@ main(int argc, char* argv[])
   visibleOptions.add_options()
     ("help,h",      "print this help message and exit")
     ("count,c",     po::value<int64_t>(), "total number of Interests to be generated")
-    ("interval,i",  po::value<ndn::time::milliseconds::rep>()->default_value(1000),
-                    "Interest generation interval in milliseconds")
+    ("interval,i",  po::value<double>()->default_value(1000),
+                    "Interest generation interval in milliseconds (fractional values are allowed)")
+    ("rate,r",      po::value<double>(), "Interest generation rate in Interests per second")
+    ("arrival,a",   po::value<std::string>()->default_value("fixed"),
+                    "Interest arrival process: fixed, poisson, onoff:ON_MS:OFF_MS, or ramp:FROM:TO:SECONDS")
+    ("window,w",    po::value<std::size_t>(),
+                    "keep this many Interests outstanding at all times, instead of sending at a fixed interval")
+    ("adaptive-window", po::bool_switch(), "adapt the window size to Nacks and timeouts (AIMD)")
+    ("max-outstanding", po::value<std::size_t>(),
+                    "never have more than this many Interests in flight; sending opportunities are skipped "
+                    "while the limit is reached")
     ("timestamp-format,t", po::value<std::string>(&timestampFormat), "format string for timestamp output")
     ("quiet,q",     po::bool_switch(), "turn off logging of Interest generation and Data reception")
+    ("async-logging", po::bool_switch(), "log from a background thread, dropping per-packet lines when it falls behind")
     ("verbose,v",   po::bool_switch(), "log additional per-packet information")
+    ("brief",       po::bool_switch(), "do not print the configuration and statistics of each traffic pattern")
+    ("nonce-window", po::value<std::size_t>()->default_value(1000),
+                    "number of recent nonces remembered for duplicate avoidance and NonceDuplicationPercentage")
+    ("threads,T",   po::value<std::size_t>()->default_value(1),
+                    "number of generator threads; each one sends Interests at the given interval")
+    ("timeout",     po::value<double>(),
+                    "count Interests as timed out after this many milliseconds, and Data arriving later as late")
+    ("trace-file",  po::value<std::string>(),
+                    "write per-packet events to this binary trace file instead of the log")
+    ("replay",      po::value<std::string>(),
+                    "send the Interests recorded in this pcap file or binary trace file at their original "
+                    "times, instead of generating them")
+    ("replay-speed", po::value<double>()->default_value(1.0),
+                    "replay this many times faster than recorded")
+    ("report-interval", po::value<double>(), "print the statistics of the last interval every this many seconds")
+    ("report-format", po::value<std::string>()->default_value("text"),
+                    "format of the interval reports: text, json, or csv")
+    ("metrics-listen", po::value<std::string>(),
+                    "serve Prometheus metrics over HTTP at this HOST:PORT (the path is /metrics)")
+    ;
+  ndntg::MemoryWatchdog::addCommandLineOptions(visibleOptions);
+  ndntg::TransportOptions::addCommandLineOptions(visibleOptions);
+  ndntg::EventLoopOptions::addCommandLineOptions(visibleOptions);
+  visibleOptions.add_options()
+    ("agents",      po::value<std::size_t>(),
+                    "run as the controller of this many agents, which send the Interests; requires "
+                    "'--controller-listen'")
+    ("controller-listen", po::value<std::string>(), "wait for the agents at this HOST:PORT")
+    ("controller",  po::value<std::string>(),
+                    "run as an agent of the controller at HOST:PORT, which provides the configuration, "
+                    "the share of '--count' and '--window', and the start time")
     ;
 
   po::options_description hiddenOptions;
@@ -634,7 +130,8 @@ main(int argc, char* argv[])
     return 0;
   }
 
-  if (configFile.empty()) {
+  bool isAgent = vm.count("controller") > 0;
+  if (configFile.empty() != isAgent) {
     usage(std::cerr, argv[0], visibleOptions);
     return 2;
   }
@@ -650,19 +147,214 @@ main(int argc, char* argv[])
     client.setMaximumInterests(static_cast<uint64_t>(count));
   }
 
-  if (vm.count("interval") > 0) {
-    ndn::time::milliseconds interval(vm["interval"].as<ndn::time::milliseconds::rep>());
-    if (interval <= 0_ms) {
+  if (vm.count("rate") > 0) {
+    if (!vm["interval"].defaulted()) {
+      std::cerr << "ERROR: cannot set both '--interval' and '--rate'\n";
+      return 2;
+    }
+    auto rate = vm["rate"].as<double>();
+    if (!(rate > 0) || !std::isfinite(rate) || rate > 1e9) {
+      std::cerr << "ERROR: the argument for option '--rate' must be positive and at most 1e9\n";
+      return 2;
+    }
+    client.setInterestInterval(std::chrono::nanoseconds(std::llround(1e9 / rate)));
+  }
+  else if (vm.count("interval") > 0) {
+    auto interval = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::duration<double, std::milli>(vm["interval"].as<double>()));
+    if (interval <= std::chrono::nanoseconds::zero()) {
       std::cerr << "ERROR: the argument for option '--interval' must be positive\n";
       return 2;
     }
     client.setInterestInterval(interval);
   }
 
+  try {
+    client.setArrivalProcess(ndntg::ArrivalProcess::parse(vm["arrival"].as<std::string>()));
+  }
+  catch (const std::exception&) {
+    std::cerr << "ERROR: invalid argument for option '--arrival'\n";
+    return 2;
+  }
+
+  if (vm.count("window") > 0) {
+    if (!vm["arrival"].defaulted()) {
+      std::cerr << "ERROR: cannot set both '--arrival' and '--window'\n";
+      return 2;
+    }
+    auto window = vm["window"].as<std::size_t>();
+    if (window == 0) {
+      std::cerr << "ERROR: the argument for option '--window' must be positive\n";
+      return 2;
+    }
+    if (!vm["interval"].defaulted() || vm.count("rate") > 0) {
+      std::cerr << "ERROR: cannot set '--window' together with '--interval' or '--rate'\n";
+      return 2;
+    }
+    client.setInterestWindow(window, vm["adaptive-window"].as<bool>());
+  }
+  else if (vm["adaptive-window"].as<bool>()) {
+    std::cerr << "ERROR: '--adaptive-window' requires '--window'\n";
+    return 2;
+  }
+
+  if (vm.count("max-outstanding") > 0) {
+    auto n = vm["max-outstanding"].as<std::size_t>();
+    if (n == 0) {
+      std::cerr << "ERROR: the argument for option '--max-outstanding' must be positive\n";
+      return 2;
+    }
+    client.setMaximumOutstanding(n);
+  }
+
+  if (vm.count("nonce-window") > 0) {
+    auto window = vm["nonce-window"].as<std::size_t>();
+    if (window == 0) {
+      std::cerr << "ERROR: the argument for option '--nonce-window' must be positive\n";
+      return 2;
+    }
+    client.setNonceWindow(window);
+  }
+
+  if (vm.count("threads") > 0) {
+    auto nThreads = vm["threads"].as<std::size_t>();
+    if (nThreads == 0) {
+      std::cerr << "ERROR: the argument for option '--threads' must be positive\n";
+      return 2;
+    }
+    client.setThreads(nThreads);
+  }
+
+  if (vm.count("timeout") > 0) {
+    auto timeout = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::duration<double, std::milli>(vm["timeout"].as<double>()));
+    if (timeout <= std::chrono::nanoseconds::zero()) {
+      std::cerr << "ERROR: the argument for option '--timeout' must be positive\n";
+      return 2;
+    }
+    client.setTimeout(timeout);
+  }
+
+  try {
+    client.setEventLoopOptions(ndntg::EventLoopOptions::fromCommandLine(vm));
+    client.setTransportOptions(ndntg::TransportOptions::fromCommandLine(vm));
+    if (auto limit = ndntg::MemoryWatchdog::fromCommandLine(vm); limit) {
+      client.setMemoryLimit(*limit);
+    }
+  }
+  catch (const std::invalid_argument& e) {
+    std::cerr << "ERROR: " << e.what() << "\n";
+    return 2;
+  }
+
+  if (vm.count("report-interval") > 0) {
+    auto interval = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::duration<double>(vm["report-interval"].as<double>()));
+    if (interval <= std::chrono::nanoseconds::zero()) {
+      std::cerr << "ERROR: the argument for option '--report-interval' must be positive\n";
+      return 2;
+    }
+    try {
+      client.setReportInterval(interval,
+                               ndntg::IntervalReporter::parseFormat(vm["report-format"].as<std::string>()));
+    }
+    catch (const std::exception&) {
+      std::cerr << "ERROR: invalid argument for option '--report-format'\n";
+      return 2;
+    }
+  }
+
+  if (vm.count("agents") > 0) {
+    if (isAgent) {
+      std::cerr << "ERROR: cannot set both '--agents' and '--controller'\n";
+      return 2;
+    }
+    if (vm.count("controller-listen") == 0) {
+      std::cerr << "ERROR: '--agents' requires '--controller-listen'\n";
+      return 2;
+    }
+    auto nAgents = vm["agents"].as<std::size_t>();
+    if (nAgents == 0) {
+      std::cerr << "ERROR: the argument for option '--agents' must be positive\n";
+      return 2;
+    }
+    // every agent needs a share of at least one
+    if ((vm.count("count") > 0 && vm["count"].as<int64_t>() < static_cast<int64_t>(nAgents)) ||
+        (vm.count("window") > 0 && vm["window"].as<std::size_t>() < nAgents)) {
+      std::cerr << "ERROR: '--count' and '--window' cannot be less than '--agents'\n";
+      return 2;
+    }
+    try {
+      client.setAgents(ndntg::MetricsServer::parseEndpoint(vm["controller-listen"].as<std::string>()), nAgents);
+    }
+    catch (const std::exception&) {
+      std::cerr << "ERROR: invalid argument for option '--controller-listen'\n";
+      return 2;
+    }
+  }
+  else if (vm.count("controller-listen") > 0) {
+    std::cerr << "ERROR: '--controller-listen' requires '--agents'\n";
+    return 2;
+  }
+
+  if (isAgent) {
+    if (vm.count("count") > 0 || vm.count("window") > 0) {
+      std::cerr << "ERROR: '--count' and '--window' are set by the controller, not by '--controller' agents\n";
+      return 2;
+    }
+    try {
+      client.setController(ndntg::MetricsServer::parseEndpoint(vm["controller"].as<std::string>()));
+    }
+    catch (const std::exception&) {
+      std::cerr << "ERROR: invalid argument for option '--controller'\n";
+      return 2;
+    }
+  }
+
+  if (vm.count("replay") > 0) {
+    if (vm.count("window") > 0 || vm.count("rate") > 0 || !vm["interval"].defaulted() ||
+        !vm["arrival"].defaulted()) {
+      std::cerr << "ERROR: cannot set '--replay' together with '--window', '--rate', '--interval', or '--arrival'\n";
+      return 2;
+    }
+    if (vm.count("agents") > 0) {
+      std::cerr << "ERROR: cannot set both '--replay' and '--agents'\n";
+      return 2;
+    }
+    auto speed = vm["replay-speed"].as<double>();
+    if (!(speed > 0) || !std::isfinite(speed)) {
+      std::cerr << "ERROR: the argument for option '--replay-speed' must be positive\n";
+      return 2;
+    }
+    client.setReplayFile(vm["replay"].as<std::string>(), speed);
+  }
+  else if (!vm["replay-speed"].defaulted()) {
+    std::cerr << "ERROR: '--replay-speed' requires '--replay'\n";
+    return 2;
+  }
+
+  if (vm.count("metrics-listen") > 0) {
+    try {
+      client.setMetricsEndpoint(ndntg::MetricsServer::parseEndpoint(vm["metrics-listen"].as<std::string>()));
+    }
+    catch (const std::exception&) {
+      std::cerr << "ERROR: invalid argument for option '--metrics-listen'\n";
+      return 2;
+    }
+  }
+
+  if (vm.count("trace-file") > 0) {
+    client.setTraceFile(vm["trace-file"].as<std::string>());
+  }
+
   if (!timestampFormat.empty()) {
     client.setTimestampFormat(std::move(timestampFormat));
   }
 
+  if (vm["async-logging"].as<bool>()) {
+    client.setAsyncLogging();
+  }
+
   if (vm["quiet"].as<bool>()) {
     if (vm["verbose"].as<bool>()) {
       std::cerr << "ERROR: cannot set both '--quiet' and '--verbose'\n";
@@ -675,5 +367,9 @@ main(int argc, char* argv[])
     client.setVerboseLogging();
   }
 
+  if (vm["brief"].as<bool>()) {
+    client.setBriefLogging();
+  }
+
   return client.run();
 }
@@ -0,0 +1,3033 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2023, Arizona Board of Regents.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Jerald Paul Abraham <jeraldabraham@email.arizona.edu>
+ */
+
+#ifndef NDNTG_NDN_TRAFFIC_CLIENT_HPP
+#define NDNTG_NDN_TRAFFIC_CLIENT_HPP
+
+#include "alias-table.hpp"
+#include "arrival-process.hpp"
+#include "batching-transport.hpp"
+#include "coordinator.hpp"
+#include "event-loop.hpp"
+#include "interval-report.hpp"
+#include "latency-histogram.hpp"
+#include "memory-usage.hpp"
+#include "metrics-server.hpp"
+#include "name-distribution.hpp"
+#include "nonce-history.hpp"
+#include "profiler.hpp"
+#include "replay.hpp"
+#include "trace.hpp"
+#include "util.hpp"
+
+#include <ndn-cxx/data.hpp>
+#include <ndn-cxx/face.hpp>
+#include <ndn-cxx/interest.hpp>
+#include <ndn-cxx/lp/tags.hpp>
+#include <ndn-cxx/security/certificate.hpp>
+#include <ndn-cxx/security/transform/public-key.hpp>
+#include <ndn-cxx/security/verification-helpers.hpp>
+#include <ndn-cxx/util/io.hpp>
+#include <ndn-cxx/util/random.hpp>
+#include <ndn-cxx/util/sha256.hpp>
+#include <ndn-cxx/util/string-helper.hpp>
+#include <ndn-cxx/util/time.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/signal_set.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/core/noncopyable.hpp>
+#include <boost/crc.hpp>
+#include <boost/lexical_cast.hpp>
+
+namespace ndntg {
+
+using namespace ndn::time_literals;
+using namespace std::string_literals;
+
+namespace time = ndn::time;
+
+class NdnTrafficClient : boost::noncopyable
+{
+public:
+  using FaceFactory = std::function<std::unique_ptr<ndn::Face>(boost::asio::io_context& io)>;
+
+  explicit
+  NdnTrafficClient(std::string configFile)
+    : m_configurationFile(std::move(configFile))
+  {
+  }
+
+  void
+  setMaximumInterests(uint64_t maxInterests)
+  {
+    m_nMaximumInterests = maxInterests;
+  }
+
+  void
+  setInterestInterval(std::chrono::nanoseconds interval)
+  {
+    BOOST_ASSERT(interval > std::chrono::nanoseconds::zero());
+    m_interestInterval = interval;
+  }
+
+  void
+  setTimestampFormat(std::string format)
+  {
+    m_timestampFormat = std::move(format);
+  }
+
+  void
+  setQuietLogging()
+  {
+    m_wantQuiet = true;
+  }
+
+  void
+  setAsyncLogging()
+  {
+    m_wantAsyncLogging = true;
+  }
+
+  void
+  setVerboseLogging()
+  {
+    m_wantVerbose = true;
+  }
+
+  /**
+   * \brief Omits the configuration and statistics of every single traffic pattern.
+   */
+  void
+  setBriefLogging()
+  {
+    m_wantBrief = true;
+  }
+
+  /**
+   * \brief Enables closed-loop operation with a window of \p window outstanding Interests.
+   * \param isAdaptive adapt the window with AIMD on Nacks and timeouts
+   */
+  void
+  setInterestWindow(std::size_t window, bool isAdaptive)
+  {
+    BOOST_ASSERT(window > 0);
+    m_interestWindow = window;
+    m_isWindowAdaptive = isAdaptive;
+  }
+
+  /**
+   * \brief Never lets more than \p n Interests be in flight at once: the generator skips its
+   *        sending opportunities while the limit is reached.
+   */
+  void
+  setMaximumOutstanding(std::size_t n)
+  {
+    BOOST_ASSERT(n > 0);
+    m_nMaximumOutstanding = n;
+  }
+
+  void
+  setArrivalProcess(const ArrivalProcess& process)
+  {
+    m_arrivalProcess = process;
+  }
+
+  /**
+   * \brief Sets how many of the most recent nonces are remembered, per generator thread.
+   *
+   * New nonces are guaranteed not to repeat any nonce in this window; duplicate nonces
+   * (see NonceDuplicationPercentage) are picked from it.
+   */
+  void
+  setNonceWindow(std::size_t window)
+  {
+    BOOST_ASSERT(window > 0);
+    m_nonceWindow = window;
+  }
+
+  void
+  setThreads(std::size_t nThreads)
+  {
+    BOOST_ASSERT(nThreads > 0);
+    m_nThreads = nThreads;
+  }
+
+  /**
+   * \brief Counts an Interest as timed out after \p timeout, even if its lifetime is longer.
+   *
+   * The Interest stays pending, so that Data arriving after the deadline is counted as late.
+   */
+  void
+  setTimeout(std::chrono::nanoseconds timeout)
+  {
+    BOOST_ASSERT(timeout > std::chrono::nanoseconds::zero());
+    m_timeout = timeout;
+  }
+
+  /**
+   * \brief Prints the statistics of the last \p interval every \p interval while running.
+   */
+  void
+  setReportInterval(std::chrono::nanoseconds interval, IntervalReporter::Format format)
+  {
+    BOOST_ASSERT(interval > std::chrono::nanoseconds::zero());
+    m_reportInterval = interval;
+    m_intervalReporter = IntervalReporter(format);
+  }
+
+  /**
+   * \brief Serves the traffic counters in the Prometheus format at http://\p endpoint/metrics.
+   */
+  void
+  setMetricsEndpoint(const boost::asio::ip::tcp::endpoint& endpoint)
+  {
+    m_metricsEndpoint = endpoint;
+  }
+
+  /**
+   * \brief Records every Interest, Data, Nack, and timeout in a binary trace file.
+   *
+   * Per-packet text log lines are not produced when tracing is enabled.
+   */
+  void
+  setTraceFile(std::string filename)
+  {
+    m_traceFile = std::move(filename);
+  }
+
+  /**
+   * \brief Stops with an error once the resident memory of the process exceeds \p limit bytes.
+   */
+  void
+  setMemoryLimit(uint64_t limit)
+  {
+    BOOST_ASSERT(limit > 0);
+    m_memoryWatchdog.setLimit(limit);
+  }
+
+  /**
+   * \brief Chooses the transport and the write batching of the Face of every worker.
+   */
+  void
+  setTransportOptions(TransportOptions options)
+  {
+    m_transportOptions = std::move(options);
+  }
+
+  /**
+   * \brief Chooses the CPUs of the workers and how they wait for packets.
+   */
+  void
+  setEventLoopOptions(EventLoopOptions options)
+  {
+    m_eventLoopOptions = std::move(options);
+  }
+
+  /**
+   * \brief Instead of generating Interests as per the traffic patterns, sends the Interests
+   *        recorded in \p filename at their original times, \p speed times faster.
+   *
+   * The file is either a pcap capture, whose Interests are sent with their original names,
+   * or a trace written with setTraceFile(), whose Interests are generated by the traffic
+   * pattern that they were recorded for.
+   */
+  void
+  setReplayFile(std::string filename, double speed)
+  {
+    BOOST_ASSERT(speed > 0.0);
+    m_replayFile = std::move(filename);
+    m_replaySpeed = speed;
+  }
+
+  /**
+   * \brief Runs as the controller of \p nAgents agents, which connect to \p endpoint.
+   *
+   * The controller sends no Interests: it sends the configuration file and a share of
+   * `--count` and `--window` to every agent, and then reports the statistics of all agents.
+   */
+  void
+  setAgents(const boost::asio::ip::tcp::endpoint& endpoint, std::size_t nAgents)
+  {
+    BOOST_ASSERT(nAgents > 0);
+    m_agentsEndpoint = endpoint;
+    m_nAgents = nAgents;
+  }
+
+  /**
+   * \brief Runs as an agent of the controller at \p endpoint, which provides the configuration
+   *        and the start time, and to which the statistics are sent at the end.
+   */
+  void
+  setController(const boost::asio::ip::tcp::endpoint& endpoint)
+  {
+    m_controllerEndpoint = endpoint;
+  }
+
+  /**
+   * \brief Creates the Face of every worker, instead of connecting to the local forwarder.
+   *
+   * This is meant for ndn-traffic-benchmark, which replaces the forwarder with in-process faces.
+   */
+  void
+  setFaceFactory(FaceFactory factory)
+  {
+    m_faceFactory = std::move(factory);
+  }
+
+  int
+  run()
+  {
+    m_logger.initialize(std::to_string(ndn::random::generateWord32()), m_timestampFormat);
+    if (m_wantAsyncLogging) {
+      m_logger.startAsync();
+    }
+
+    if (m_nAgents > 0) {
+      return runController();
+    }
+    if (!m_controllerEndpoint) {
+      return runTraffic();
+    }
+
+    if (!receiveAssignment()) {
+      return 2;
+    }
+    int exitCode = runTraffic();
+    sendResult(exitCode);
+    return exitCode;
+  }
+
+private:
+  int
+  runTraffic()
+  {
+    if (m_configurationText) {
+      parseConfiguration(*m_configurationText, m_trafficPatterns, m_logger);
+    }
+    else if (!readConfigurationFile(m_configurationFile, m_trafficPatterns, m_logger)) {
+      return 2;
+    }
+
+    if (!checkTrafficPatternCorrectness(m_trafficPatterns)) {
+      m_logger.log("ERROR: Traffic configuration provided is not proper", false, true);
+      return 2;
+    }
+    updateTrafficMix();
+
+    m_logger.log("Traffic configuration file processing completed\n", true, false);
+    for (std::size_t i = 0; i < m_trafficPatterns.size() && !m_wantBrief; i++) {
+      m_logger.log("Traffic Pattern Type #" + std::to_string(i + 1), false, false);
+      m_trafficPatterns[i].printTrafficConfiguration(m_logger);
+      m_logger.log("", false, false);
+    }
+
+    if (m_nMaximumInterests == 0) {
+      logStatistics();
+      return 0;
+    }
+
+    if (m_interestWindow && m_totalTrafficPercentage <= 0.0) {
+      m_logger.log("ERROR: Window mode requires at least one pattern with a positive TrafficPercentage",
+                   false, true);
+      return 2;
+    }
+
+    if (!m_replayFile.empty()) {
+      try {
+        m_replayReader = std::make_unique<ReplayReader>(m_replayFile);
+      }
+      catch (const std::exception& e) {
+        m_logger.log("ERROR: "s + e.what(), false, true);
+        return 2;
+      }
+      // a binary trace refers to its patterns by position, which may differ from this configuration
+      for (const auto& traceName : m_replayReader->getPatternNames()) {
+        auto it = std::find_if(m_trafficPatterns.begin(), m_trafficPatterns.end(),
+                               [name = ndn::Name(traceName)] (const auto& pattern) { return pattern.m_prefix == name; });
+        if (it == m_trafficPatterns.end()) {
+          m_logger.log("WARNING: No traffic pattern for " + traceName + ", its Interests are skipped", false, true);
+          m_replayPatterns.emplace_back();
+        }
+        else {
+          m_replayPatterns.emplace_back(static_cast<std::size_t>(it - m_trafficPatterns.begin()));
+        }
+      }
+    }
+
+    if (!m_traceFile.empty()) {
+      std::vector<std::string> patternNames;
+      for (const auto& pattern : m_trafficPatterns) {
+        patternNames.push_back(pattern.m_prefix.toUri());
+      }
+      try {
+        m_traceWriter = std::make_unique<trace::TraceWriter>(m_traceFile, patternNames);
+      }
+      catch (const std::exception& e) {
+        m_logger.log("ERROR: "s + e.what(), false, true);
+        return 2;
+      }
+    }
+
+    if (m_metricsEndpoint) {
+      try {
+        m_metricsServer = std::make_unique<MetricsServer>(m_io, *m_metricsEndpoint,
+                                                          [this] (auto reply) { collectMetrics(std::move(reply)); });
+      }
+      catch (const std::exception& e) {
+        m_logger.log("ERROR: cannot listen for metrics requests: "s + e.what(), false, true);
+        return 2;
+      }
+    }
+
+    auto faceFactory = m_faceFactory;
+    if (!faceFactory) {
+      try {
+        faceFactory = m_transportOptions.makeFaceFactory(m_eventLoopOptions.m_socketBusyPoll, false);
+      }
+      catch (const std::exception& e) {
+        m_logger.log("ERROR: "s + e.what(), false, true);
+        return 2;
+      }
+    }
+
+    auto nWorkers = m_nThreads;
+    if (m_nMaximumInterests && *m_nMaximumInterests < nWorkers) {
+      nWorkers = static_cast<std::size_t>(*m_nMaximumInterests);
+    }
+    if (m_interestWindow && *m_interestWindow < nWorkers) {
+      nWorkers = *m_interestWindow;
+    }
+    if (m_nMaximumOutstanding && *m_nMaximumOutstanding < nWorkers) {
+      nWorkers = *m_nMaximumOutstanding;
+    }
+    if (m_replayReader && nWorkers > 1) {
+      m_logger.log("Using 1 worker thread (replay)", false, true);
+      nWorkers = 1;
+    }
+    for (std::size_t i = 0; i < nWorkers; i++) {
+      // the first worker runs on the main thread and shares its io_context with the signal set
+      m_workers.push_back(std::make_unique<Worker>(*this, i, nWorkers, m_trafficPatterns, m_nonceWindow,
+                                                    faceFactory, i == 0 ? &m_io : nullptr));
+      auto& worker = *m_workers.back();
+      worker.m_patternSelector = m_patternSelector;
+      worker.m_totalTrafficPercentage = m_totalTrafficPercentage;
+      if (m_nMaximumInterests) {
+        // split --count evenly, the first workers take the remainder
+        worker.m_nMaximumInterests = *m_nMaximumInterests / nWorkers + (i < *m_nMaximumInterests % nWorkers);
+      }
+      if (m_interestWindow) {
+        // likewise for the window
+        worker.m_window = static_cast<double>(*m_interestWindow / nWorkers + (i < *m_interestWindow % nWorkers));
+      }
+      if (m_nMaximumOutstanding) {
+        worker.m_nMaximumOutstanding = *m_nMaximumOutstanding / nWorkers + (i < *m_nMaximumOutstanding % nWorkers);
+        if (m_interestWindow) {
+          worker.m_window = std::min(worker.m_window, static_cast<double>(*worker.m_nMaximumOutstanding));
+        }
+      }
+      if (m_interestWindow) {
+        worker.m_outstanding = OutstandingTable(2 * static_cast<std::size_t>(worker.m_window));
+      }
+      else if (worker.m_nMaximumOutstanding) {
+        worker.m_outstanding = OutstandingTable(2 * *worker.m_nMaximumOutstanding);
+      }
+      if (m_traceWriter) {
+        worker.m_trace = std::make_unique<trace::TraceWriter::Buffer>(*m_traceWriter);
+      }
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    if (m_startTime) {
+      auto delay = *m_startTime - std::chrono::system_clock::now();
+      if (delay > MAX_START_DELAY) {
+        m_logger.log("ERROR: The start time of the controller is " +
+                     std::to_string(std::chrono::duration<double>(delay).count()) +
+                     "s away, the clocks of the machines are not synchronized", false, true);
+        return 2;
+      }
+      if (delay > std::chrono::system_clock::duration::zero()) {
+        startTime += std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay);
+      }
+      else {
+        m_logger.log("WARNING: Started " +
+                     std::to_string(std::chrono::duration<double, std::milli>(-delay).count()) +
+                     "ms after the start time of the controller", true, true);
+      }
+    }
+
+    // wait for the start time in the event loops, so that a signal can still stop the client
+    m_signalSet.async_wait([this] (const boost::system::error_code& ec, int) {
+      if (ec != boost::asio::error::operation_aborted) {
+        stop();
+      }
+    });
+    m_startTimer.expires_at(startTime);
+    m_startTimer.async_wait([this] (const boost::system::error_code& ec) {
+      if (ec) {
+        return;
+      }
+      // an agent has no configuration file of its own to reload
+      if (!m_configurationText) {
+        waitForReload();
+      }
+      if (m_reportInterval) {
+        m_reportStartTime = m_lastReportTime = std::chrono::steady_clock::now();
+        scheduleReport();
+      }
+      m_memoryWatchdog.start([this] (const std::string& error) {
+        m_logger.log("ERROR: " + error, true, true);
+        m_hasError = true;
+        stop();
+      });
+    });
+    // the pending timer also keeps the event loop of each worker running until then
+    for (auto& worker : m_workers) {
+      worker->m_timer.expires_at(startTime);
+      worker->m_timer.async_wait([this, &worker = *worker] (const boost::system::error_code& ec) {
+        if (!ec) {
+          startWorker(worker);
+        }
+      });
+    }
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < m_workers.size(); i++) {
+      threads.emplace_back([this, &worker = *m_workers[i]] {
+        try {
+          placeWorker(worker);
+          m_eventLoopOptions.run(*worker.m_face);
+        }
+        catch (const std::exception& e) {
+          m_logger.log("ERROR: "s + e.what(), true, true);
+          m_hasError = true;
+          boost::asio::post(m_io, [this] { stop(); });
+        }
+      });
+    }
+
+    int exitCode = 0;
+    try {
+      placeWorker(*m_workers.front());
+      m_eventLoopOptions.run(*m_workers.front()->m_face);
+    }
+    catch (const std::exception& e) {
+      m_logger.log("ERROR: "s + e.what(), true, true);
+      shutdownWorkers();
+      m_io.stop();
+      exitCode = 1;
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    for (auto& worker : m_workers) {
+      if (worker->m_trace) {
+        worker->m_trace->flush();
+      }
+    }
+    if (exitCode != 0) {
+      return exitCode;
+    }
+
+    mergeStatistics();
+    if (m_stats.m_nContentInconsistencies > 0 || m_stats.m_nSignatureFailures > 0 ||
+        m_stats.m_nInterestsSent != m_stats.m_nInterestsReceived) {
+      m_hasError = true;
+    }
+    logStatistics();
+    return m_hasError ? 1 : 0;
+  }
+
+  class TrafficStatistics
+  {
+  public:
+    void
+    addRoundTripTime(std::chrono::nanoseconds rtt)
+    {
+      m_roundTripTimes.record(static_cast<uint64_t>(std::max<std::chrono::nanoseconds::rep>(0, rtt.count())));
+      m_totalInterestRoundTripTime += rtt.count() / 1e6;
+    }
+
+    void
+    addVerification(bool isValid, std::chrono::nanoseconds duration)
+    {
+      m_nSignaturesVerified++;
+      m_nSignatureFailures += !isValid;
+      m_totalVerificationTime += duration;
+    }
+
+    void
+    addObject(bool isComplete, std::chrono::nanoseconds completionTime, uint64_t nBytes)
+    {
+      if (!isComplete) {
+        m_nObjectsFailed++;
+        return;
+      }
+      m_nObjectsCompleted++;
+      m_nObjectBytes += nBytes;
+      m_objectCompletionTimes.record(static_cast<uint64_t>(std::max<std::chrono::nanoseconds::rep>(0, completionTime.count())));
+    }
+
+    void
+    merge(const TrafficStatistics& other)
+    {
+      m_nInterestsSent += other.m_nInterestsSent;
+      m_nInterestsReceived += other.m_nInterestsReceived;
+      m_nHeldBack += other.m_nHeldBack;
+      m_nNacks += other.m_nNacks;
+      m_nTimeouts += other.m_nTimeouts;
+      m_nLateData += other.m_nLateData;
+      m_nContentInconsistencies += other.m_nContentInconsistencies;
+      m_nSignaturesVerified += other.m_nSignaturesVerified;
+      m_nSignatureFailures += other.m_nSignatureFailures;
+      m_totalVerificationTime += other.m_totalVerificationTime;
+      m_roundTripTimes.merge(other.m_roundTripTimes);
+      m_totalInterestRoundTripTime += other.m_totalInterestRoundTripTime;
+      m_nObjectsCompleted += other.m_nObjectsCompleted;
+      m_nObjectsFailed += other.m_nObjectsFailed;
+      m_nObjectBytes += other.m_nObjectBytes;
+      m_objectCompletionTimes.merge(other.m_objectCompletionTimes);
+    }
+
+    /**
+     * \brief Writes the statistics as three lines of text, which load() reads back.
+     */
+    void
+    save(std::ostream& os) const
+    {
+      os << m_nInterestsSent << ' ' << m_nInterestsReceived << ' ' << m_nHeldBack << ' '
+         << m_nNacks << ' ' << m_nTimeouts << ' ' << m_nLateData << ' ' << m_nContentInconsistencies << ' '
+         << m_nSignaturesVerified << ' ' << m_nSignatureFailures << ' ' << m_totalVerificationTime.count() << ' '
+         << std::setprecision(17) << m_totalInterestRoundTripTime << ' '
+         << m_nObjectsCompleted << ' ' << m_nObjectsFailed << ' ' << m_nObjectBytes << '\n'
+         << m_roundTripTimes.toString() << '\n'
+         << m_objectCompletionTimes.toString() << '\n';
+    }
+
+    /**
+     * \throw std::invalid_argument \p is does not start with the output of save()
+     */
+    static TrafficStatistics
+    load(std::istream& is)
+    {
+      TrafficStatistics stats;
+      std::chrono::nanoseconds::rep verificationTime = 0;
+      is >> stats.m_nInterestsSent >> stats.m_nInterestsReceived >> stats.m_nHeldBack
+         >> stats.m_nNacks >> stats.m_nTimeouts >> stats.m_nLateData >> stats.m_nContentInconsistencies
+         >> stats.m_nSignaturesVerified >> stats.m_nSignatureFailures >> verificationTime
+         >> stats.m_totalInterestRoundTripTime
+         >> stats.m_nObjectsCompleted >> stats.m_nObjectsFailed >> stats.m_nObjectBytes;
+      std::string roundTripTimes;
+      std::string objectCompletionTimes;
+      if (!is || !std::getline(is >> std::ws, roundTripTimes) || !std::getline(is, objectCompletionTimes)) {
+        throw std::invalid_argument("truncated statistics");
+      }
+      stats.m_totalVerificationTime = std::chrono::nanoseconds(verificationTime);
+      stats.m_roundTripTimes = LatencyHistogram::fromString(roundTripTimes);
+      stats.m_objectCompletionTimes = LatencyHistogram::fromString(objectCompletionTimes);
+      return stats;
+    }
+
+    void
+    log(Logger& logger) const
+    {
+      using std::to_string;
+
+      logger.log("Total Interests Sent        = " + to_string(m_nInterestsSent), false, true);
+      logger.log("Total Responses Received    = " + to_string(m_nInterestsReceived), false, true);
+      if (m_nHeldBack > 0) {
+        logger.log("Total Interests Held Back   = " + to_string(m_nHeldBack), false, true);
+      }
+      logger.log("Total Nacks Received        = " + to_string(m_nNacks), false, true);
+      logger.log("Total Timeouts              = " + to_string(m_nTimeouts), false, true);
+      logger.log("Total Late Data Received    = " + to_string(m_nLateData), false, true);
+
+      double loss = 0.0;
+      if (m_nInterestsSent > 0) {
+        loss = (m_nInterestsSent - m_nInterestsReceived) * 100.0 / m_nInterestsSent;
+      }
+      logger.log("Total Interest Loss         = " + to_string(loss) + "%", false, true);
+
+      double average = 0.0;
+      double inconsistency = 0.0;
+      if (m_nInterestsReceived > 0) {
+        average = m_totalInterestRoundTripTime / m_nInterestsReceived;
+        inconsistency = m_nContentInconsistencies * 100.0 / m_nInterestsReceived;
+      }
+      logger.log("Total Data Inconsistency    = " + to_string(inconsistency) + "%", false, true);
+      if (m_nSignaturesVerified > 0) {
+        auto averageVerification = std::chrono::duration<double, std::milli>(m_totalVerificationTime).count() /
+                                   m_nSignaturesVerified;
+        logger.log("Total Signature Failures    = " + to_string(m_nSignatureFailures), false, true);
+        logger.log("Average Verification Time   = " + to_string(averageVerification) + "ms", false, true);
+      }
+      auto toMs = [] (uint64_t ns) { return to_string(ns / 1e6) + "ms"; };
+      if (m_nObjectsCompleted > 0 || m_nObjectsFailed > 0) {
+        logger.log("Total Objects Completed     = " + to_string(m_nObjectsCompleted), false, true);
+        logger.log("Total Objects Failed        = " + to_string(m_nObjectsFailed), false, true);
+        logger.log("Total Object Bytes          = " + to_string(m_nObjectBytes), false, true);
+        logger.log("50th Percentile Object Time = " + toMs(m_objectCompletionTimes.getPercentile(50.0)), false, true);
+        logger.log("90th Percentile Object Time = " + toMs(m_objectCompletionTimes.getPercentile(90.0)), false, true);
+        logger.log("99th Percentile Object Time = " + toMs(m_objectCompletionTimes.getPercentile(99.0)), false, true);
+        logger.log("Maximum Object Time         = " + toMs(m_objectCompletionTimes.getMax()), false, true);
+      }
+      logger.log("Total Round Trip Time       = " + to_string(m_totalInterestRoundTripTime) + "ms", false, true);
+      logger.log("Average Round Trip Time     = " + to_string(average) + "ms", false, true);
+
+      logger.log("Minimum Round Trip Time     = " + toMs(m_roundTripTimes.getMin()), false, true);
+      logger.log("50th Percentile RTT         = " + toMs(m_roundTripTimes.getPercentile(50.0)), false, true);
+      logger.log("90th Percentile RTT         = " + toMs(m_roundTripTimes.getPercentile(90.0)), false, true);
+      logger.log("99th Percentile RTT         = " + toMs(m_roundTripTimes.getPercentile(99.0)), false, true);
+      logger.log("99.9th Percentile RTT       = " + toMs(m_roundTripTimes.getPercentile(99.9)), false, true);
+      logger.log("Maximum Round Trip Time     = " + toMs(m_roundTripTimes.getMax()) + "\n", false, true);
+    }
+
+  public:
+    uint64_t m_nInterestsSent = 0;
+    uint64_t m_nInterestsReceived = 0;
+    uint64_t m_nHeldBack = 0; ///< not sent because of --max-outstanding
+    uint64_t m_nNacks = 0;
+    uint64_t m_nTimeouts = 0;
+    uint64_t m_nLateData = 0; ///< Data received after the Interest was counted as timed out
+    uint64_t m_nContentInconsistencies = 0;
+    uint64_t m_nSignaturesVerified = 0; ///< VerifySignature only
+    uint64_t m_nSignatureFailures = 0;
+    std::chrono::nanoseconds m_totalVerificationTime{0};
+
+    // total RTT is stored as milliseconds with fractional sub-milliseconds precision
+    double m_totalInterestRoundTripTime = 0;
+    LatencyHistogram m_roundTripTimes; ///< in nanoseconds
+
+    // SegmentWindow only
+    uint64_t m_nObjectsCompleted = 0;
+    uint64_t m_nObjectsFailed = 0; ///< at least one segment was Nack'd or timed out
+    uint64_t m_nObjectBytes = 0; ///< content of the completed objects
+    LatencyHistogram m_objectCompletionTimes; ///< in nanoseconds
+  };
+
+  class InterestTrafficConfiguration
+  {
+  public:
+    void
+    printTrafficConfiguration(Logger& logger) const
+    {
+      std::ostringstream os;
+
+      os << "TrafficPercentage=" << m_trafficPercentage << ", ";
+      os << "Name=" << m_name << ", ";
+      if (m_nameDistribution) {
+        os << "NameDistribution=" << *m_nameDistribution << ", ";
+      }
+      if (m_nameAppendBytes) {
+        os << "NameAppendBytes=" << *m_nameAppendBytes << ", ";
+      }
+      if (m_nameAppendSeqNum) {
+        os << "NameAppendSequenceNumber=" << *m_nameAppendSeqNum << ", ";
+      }
+      if (m_canBePrefix) {
+        os << "CanBePrefix=" << m_canBePrefix << ", ";
+      }
+      if (m_mustBeFresh) {
+        os << "MustBeFresh=" << m_mustBeFresh << ", ";
+      }
+      if (m_nonceDuplicationPercentage > 0) {
+        os << "NonceDuplicationPercentage=" << m_nonceDuplicationPercentage << ", ";
+      }
+      if (m_interestLifetime >= 0_ms) {
+        os << "InterestLifetime=" << m_interestLifetime.count() << ", ";
+      }
+      if (m_nextHopFaceId > 0) {
+        os << "NextHopFaceId=" << m_nextHopFaceId << ", ";
+      }
+      if (m_expectedContent) {
+        os << "ExpectedContent=" << *m_expectedContent << ", ";
+      }
+      if (m_expectedContentLength) {
+        os << "ExpectedContentLength=" << *m_expectedContentLength << ", ";
+      }
+      if (m_expectedContentCrc32) {
+        os << "ExpectedContentCrc32=" << std::hex << std::setw(8) << std::setfill('0')
+           << *m_expectedContentCrc32 << std::dec << ", ";
+      }
+      if (m_expectedContentSha256) {
+        os << "ExpectedContentSha256=" << ndn::toHex(*m_expectedContentSha256, false) << ", ";
+      }
+      if (!m_verifySignature.empty()) {
+        os << "VerifySignature=" << m_verifySignature << ", ";
+      }
+      if (m_arrivalProcess) {
+        os << "ArrivalProcess=" << *m_arrivalProcess << ", ";
+      }
+      if (m_segmentWindow) {
+        os << "SegmentWindow=" << *m_segmentWindow << ", ";
+      }
+
+      auto str = os.str();
+      str = str.substr(0, str.length() - 2); // remove suffix ", "
+      logger.log(str, false, false);
+    }
+
+    bool
+    parseConfigurationLine(std::string_view line, Logger& logger, int lineNumber)
+    {
+      std::string_view parameter, valueView;
+      if (!extractParameterAndValue(line, parameter, valueView)) {
+        logger.log("Line " + std::to_string(lineNumber) + " - Invalid syntax: " + std::string(line),
+                   false, true);
+        return false;
+      }
+      std::string value(valueView);
+
+      if (parameter == "TrafficPercentage") {
+        m_trafficPercentage = std::stod(value);
+        if (!std::isfinite(m_trafficPercentage)) {
+          logger.log("Line " + std::to_string(lineNumber) +
+                     " - TrafficPercentage must be a finite floating point value", false, true);
+          return false;
+        }
+      }
+      else if (parameter == "Name") {
+        m_name = value;
+      }
+      else if (parameter == "NameDistribution") {
+        try {
+          m_nameDistribution = NameDistribution::parse(value);
+        }
+        catch (const std::exception&) {
+          logger.log("Line " + std::to_string(lineNumber) + " - Invalid NameDistribution: " + value,
+                     false, true);
+          return false;
+        }
+      }
+      else if (parameter == "NameAppendBytes") {
+        m_nameAppendBytes = std::stoul(value);
+      }
+      else if (parameter == "NameAppendSequenceNumber") {
+        m_nameAppendSeqNum = std::stoull(value);
+      }
+      else if (parameter == "CanBePrefix") {
+        m_canBePrefix = parseBoolean(value);
+      }
+      else if (parameter == "MustBeFresh") {
+        m_mustBeFresh = parseBoolean(value);
+      }
+      else if (parameter == "NonceDuplicationPercentage") {
+        m_nonceDuplicationPercentage = std::stoul(value);
+      }
+      else if (parameter == "InterestLifetime") {
+        m_interestLifetime = time::milliseconds(std::stoul(value));
+      }
+      else if (parameter == "NextHopFaceId") {
+        m_nextHopFaceId = std::stoull(value);
+      }
+      else if (parameter == "ExpectedContent") {
+        m_expectedContent = value;
+      }
+      else if (parameter == "ExpectedContentLength") {
+        m_expectedContentLength = std::stoul(value);
+      }
+      else if (parameter == "ExpectedContentCrc32") {
+        if (value.empty() || value.size() > 8 ||
+            !std::all_of(value.begin(), value.end(), [] (unsigned char c) { return std::isxdigit(c); })) {
+          logger.log("Line " + std::to_string(lineNumber) + " - Invalid ExpectedContentCrc32: " + value,
+                     false, true);
+          return false;
+        }
+        m_expectedContentCrc32 = static_cast<uint32_t>(std::stoul(value, nullptr, 16));
+      }
+      else if (parameter == "ExpectedContentSha256") {
+        auto digest = ndn::fromHex(value);
+        if (digest->size() != ndn::util::Sha256::DIGEST_SIZE) {
+          logger.log("Line " + std::to_string(lineNumber) + " - Invalid ExpectedContentSha256: " + value,
+                     false, true);
+          return false;
+        }
+        m_expectedContentSha256 = std::move(digest);
+      }
+      else if (parameter == "VerifySignature") {
+        if (!parseVerifySignature(value)) {
+          logger.log("Line " + std::to_string(lineNumber) + " - Invalid VerifySignature: " + value,
+                     false, true);
+          return false;
+        }
+      }
+      else if (parameter == "ArrivalProcess") {
+        try {
+          m_arrivalProcess = ArrivalProcess::parse(value);
+        }
+        catch (const std::exception&) {
+          logger.log("Line " + std::to_string(lineNumber) + " - Invalid ArrivalProcess: " + value,
+                     false, true);
+          return false;
+        }
+      }
+      else if (parameter == "SegmentWindow") {
+        m_segmentWindow = std::stoul(value);
+      }
+      else {
+        logger.log("Line " + std::to_string(lineNumber) + " - Ignoring unknown parameter: " +
+                   std::string(parameter), false, true);
+      }
+      return true;
+    }
+
+    /**
+     * \param lineNumber first line of the pattern, for error messages
+     */
+    bool
+    checkTrafficDetailCorrectness(Logger& logger, int lineNumber) const
+    {
+      auto prefix = "Traffic pattern at line " + std::to_string(lineNumber) + " - ";
+      if (m_name.empty()) {
+        logger.log(prefix + "Missing mandatory parameter: Name", false, true);
+        return false;
+      }
+      if (m_trafficPercentage < 0.0) {
+        logger.log(prefix + "TrafficPercentage cannot be negative", false, true);
+        return false;
+      }
+      if (m_nonceDuplicationPercentage > 100) {
+        logger.log(prefix + "NonceDuplicationPercentage cannot be greater than 100", false, true);
+        return false;
+      }
+      if (m_segmentWindow == 0u) {
+        logger.log(prefix + "SegmentWindow must be positive", false, true);
+        return false;
+      }
+      return true;
+    }
+
+    /**
+     * \brief Checks the content of a Data packet against all the Expected* parameters.
+     *
+     * The payload is examined in place, cheapest checks first.
+     */
+    bool
+    isContentConsistent(ndn::span<const uint8_t> content) const
+    {
+      if (m_expectedContentLength && content.size() != *m_expectedContentLength) {
+        return false;
+      }
+      if (m_expectedContent && (content.size() != m_expectedContent->size() ||
+                                (!content.empty() && std::memcmp(content.data(), m_expectedContent->data(),
+                                                                  content.size()) != 0))) {
+        return false;
+      }
+      if (m_expectedContentCrc32) {
+        boost::crc_32_type crc;
+        crc.process_bytes(content.data(), content.size());
+        if (crc.checksum() != *m_expectedContentCrc32) {
+          return false;
+        }
+      }
+      if (m_expectedContentSha256 && *ndn::util::Sha256::computeDigest(content) != *m_expectedContentSha256) {
+        return false;
+      }
+      return true;
+    }
+
+    bool
+    hasContentCheck() const
+    {
+      return m_expectedContent || m_expectedContentLength || m_expectedContentCrc32 || m_expectedContentSha256;
+    }
+
+    bool
+    hasSignatureCheck() const
+    {
+      return !m_verifySignature.empty();
+    }
+
+    /**
+     * \pre hasSignatureCheck()
+     */
+    bool
+    verifySignature(const ndn::Data& data) const
+    {
+      if (m_verificationKey != nullptr) {
+        return ndn::security::verifySignature(data, *m_verificationKey);
+      }
+      return ndn::security::verifyDigest(data, ndn::DigestAlgorithm::SHA256);
+    }
+
+    /**
+     * \brief Pre-builds the parts of the Interest that are the same for every packet.
+     * \throw std::exception the Name cannot be parsed
+     */
+    void
+    prepareInterestTemplate()
+    {
+      m_prefix = ndn::Name(m_name);
+      m_interestTemplate = ndn::Interest(m_prefix);
+      m_interestTemplate.setCanBePrefix(m_canBePrefix);
+      m_interestTemplate.setMustBeFresh(m_mustBeFresh);
+      if (m_interestLifetime >= 0_ms) {
+        m_interestTemplate.setInterestLifetime(m_interestLifetime);
+      }
+      if (m_nextHopFaceId > 0) {
+        m_interestTemplate.setTag(std::make_shared<ndn::lp::NextHopFaceIdTag>(m_nextHopFaceId));
+      }
+
+      m_catalogue = nullptr;
+      if (m_nameDistribution) {
+        m_catalogue = getSharedCatalogue(std::min<uint64_t>(m_nameDistribution->size(), MAX_CATALOGUE_CACHE_SIZE));
+      }
+    }
+
+    /**
+     * \brief Returns the name component that identifies content \p k of the catalogue.
+     */
+    ndn::name::Component
+    getCatalogueComponent(uint64_t k) const
+    {
+      if (k < m_catalogue->size()) {
+        return (*m_catalogue)[k];
+      }
+      return ndn::name::Component::fromNumber(k);
+    }
+
+  private:
+    /**
+     * \brief Returns the components `fromNumber(0)` to at least `fromNumber(n - 1)`.
+     *
+     * The catalogue is the same for every pattern, so all of them, including those of a
+     * reloaded configuration, share the biggest one built so far while any pattern uses it.
+     */
+    static std::shared_ptr<const std::vector<ndn::name::Component>>
+    getSharedCatalogue(uint64_t n)
+    {
+      static std::mutex mutex;
+      static std::weak_ptr<const std::vector<ndn::name::Component>> shared;
+
+      std::lock_guard<std::mutex> lock(mutex);
+      auto catalogue = shared.lock();
+      if (catalogue != nullptr && catalogue->size() >= n) {
+        return catalogue;
+      }
+      auto bigger = std::make_shared<std::vector<ndn::name::Component>>();
+      bigger->reserve(n);
+      for (uint64_t k = 0; k < n; k++) {
+        bigger->push_back(ndn::name::Component::fromNumber(k));
+      }
+      catalogue = std::move(bigger);
+      shared = catalogue;
+      return catalogue;
+    }
+
+    /**
+     * \brief Parses `digest` (DigestSha256 signatures) or `cert:FILE` (a base64 certificate, as
+     *        written by `ndnsec cert-dump`, whose public key must have signed the Data).
+     */
+    bool
+    parseVerifySignature(const std::string& value)
+    {
+      if (value == "digest") {
+        m_verificationKey = nullptr;
+      }
+      else if (value.rfind("cert:", 0) == 0) {
+        auto cert = ndn::io::load<ndn::security::Certificate>(value.substr(5));
+        if (cert == nullptr) {
+          return false;
+        }
+        // decoding the key is not part of the verification of each packet
+        auto key = std::make_shared<ndn::security::transform::PublicKey>();
+        try {
+          key->loadPkcs8(cert->getPublicKey());
+        }
+        catch (const std::exception&) {
+          return false;
+        }
+        m_verificationKey = std::move(key);
+      }
+      else {
+        return false;
+      }
+      m_verifySignature = value;
+      return true;
+    }
+
+  private:
+    /// the most popular contents have the lowest numbers, so they are the ones encoded in advance
+    static constexpr uint64_t MAX_CATALOGUE_CACHE_SIZE = 1 << 20;
+
+  public:
+    double m_trafficPercentage = 0.0;
+    std::string m_name;
+    std::optional<NameDistribution> m_nameDistribution;
+    std::optional<std::size_t> m_nameAppendBytes;
+    std::optional<uint64_t> m_nameAppendSeqNum;
+    bool m_canBePrefix = false;
+    bool m_mustBeFresh = false;
+    unsigned m_nonceDuplicationPercentage = 0;
+    time::milliseconds m_interestLifetime = -1_ms;
+    uint64_t m_nextHopFaceId = 0;
+    std::optional<std::string> m_expectedContent;
+    std::optional<std::size_t> m_expectedContentLength;
+    std::optional<uint32_t> m_expectedContentCrc32;
+    ndn::ConstBufferPtr m_expectedContentSha256;
+    std::string m_verifySignature;
+    std::shared_ptr<const ndn::security::transform::PublicKey> m_verificationKey; ///< null for `digest`
+    std::optional<ArrivalProcess> m_arrivalProcess;
+    std::optional<std::size_t> m_segmentWindow; ///< fetch segmented objects, with this many segments in flight
+    bool m_isRemoved = false; ///< no longer in the configuration file since the last reload
+
+    ndn::Name m_prefix;
+    ndn::Interest m_interestTemplate;
+    /// pre-encoded name components of the first contents of m_nameDistribution, shared by all copies
+    std::shared_ptr<const std::vector<ndn::name::Component>> m_catalogue;
+
+    TrafficStatistics m_stats;
+  };
+
+  /**
+   * \brief Interests of one worker that are waiting for Data, a Nack, or a timeout.
+   *
+   * Entries are stored in a power-of-two array indexed by the worker's sequence number,
+   * so that each Interest's state is found without hashing, and sending an Interest does
+   * not allocate. Callbacks only need to carry the sequence number.
+   *
+   * An Interest that has been counted as timed out (`--timeout`) keeps its entry, so that late
+   * Data can be attributed, only until a new Interest needs the slot: such entries are evicted
+   * rather than making the array grow. The array doubles only when the slot is held by an
+   * Interest that is still within its deadline, so its size is bounded by the number of
+   * Interests sent during one `--timeout` (or InterestLifetime), and not by bursts of
+   * Interests that never get an answer.
+   */
+  class OutstandingTable
+  {
+  public:
+    class Entry
+    {
+    public:
+      uint64_t m_seq = 0; ///< 0 if the slot is free
+      uint64_t m_localRef = 0;
+      std::size_t m_patternId = 0;
+      uint32_t m_nonce = 0;
+      uint64_t m_objectId = 0; ///< 0 unless the Interest is for a segment of an object
+      bool m_hasTimedOut = false; ///< counted as timed out (--timeout), but still pending in the Face
+      std::chrono::steady_clock::time_point m_sentTime;
+    };
+
+    explicit
+    OutstandingTable(std::size_t capacity = 1024)
+    {
+      std::size_t size = 16;
+      while (size < capacity) {
+        size <<= 1;
+      }
+      m_entries.resize(size);
+    }
+
+    /**
+     * \pre \p seq is greater than the sequence number of every entry in the table
+     */
+    Entry&
+    insert(uint64_t seq)
+    {
+      BOOST_ASSERT(seq > 0);
+      while (m_entries[seq & (m_entries.size() - 1)].m_seq != 0 &&
+             !m_entries[seq & (m_entries.size() - 1)].m_hasTimedOut) {
+        grow();
+      }
+      auto& entry = m_entries[seq & (m_entries.size() - 1)];
+      if (entry.m_seq != 0) {
+        // already counted as timed out; its late Data, if any, is handled by the caller of find()
+        m_size--;
+      }
+      entry = Entry{};
+      entry.m_seq = seq;
+      m_size++;
+      return entry;
+    }
+
+    /**
+     * \return the entry of \p seq, or nullptr if it has timed out and its slot has been reused
+     */
+    Entry*
+    find(uint64_t seq)
+    {
+      auto& entry = m_entries[seq & (m_entries.size() - 1)];
+      return entry.m_seq == seq ? &entry : nullptr;
+    }
+
+    void
+    erase(Entry& entry)
+    {
+      BOOST_ASSERT(entry.m_seq != 0);
+      entry.m_seq = 0;
+      m_size--;
+    }
+
+    std::size_t
+    size() const
+    {
+      return m_size;
+    }
+
+    std::size_t
+    getCapacity() const
+    {
+      return m_entries.size();
+    }
+
+  private:
+    void
+    grow()
+    {
+      std::vector<Entry> entries(m_entries.size() * 2);
+      for (const auto& entry : m_entries) {
+        if (entry.m_seq != 0) {
+          entries[entry.m_seq & (entries.size() - 1)] = entry;
+        }
+      }
+      m_entries = std::move(entries);
+    }
+
+  private:
+    std::vector<Entry> m_entries;
+    std::size_t m_size = 0;
+  };
+
+  /**
+   * \brief State of one Interest generator thread.
+   *
+   * Each worker has its own io_context, Face, timer, and nonce history, as well as its own
+   * copy of the traffic patterns and of the pattern selector, so that generators never share
+   * mutable state. Statistics are merged once all workers have stopped.
+   */
+  class Worker : boost::noncopyable
+  {
+  public:
+    Worker(NdnTrafficClient& client, std::size_t id, std::size_t nWorkers,
+           std::vector<InterestTrafficConfiguration> patterns, std::size_t nonceWindow,
+           const FaceFactory& faceFactory, boost::asio::io_context* io = nullptr)
+      : m_client(&client)
+      , m_id(id)
+      , m_nWorkers(nWorkers)
+      , m_ownIo(io == nullptr ? std::make_unique<boost::asio::io_context>() : nullptr)
+      , m_io(io == nullptr ? *m_ownIo : *io)
+      , m_face(faceFactory ? faceFactory(m_io) : std::make_unique<ndn::Face>(m_io))
+      , m_trafficPatterns(std::move(patterns))
+      , m_nonces(nonceWindow)
+    {
+      // interleave sequence numbers, so that names stay unique across workers
+      for (auto& pattern : m_trafficPatterns) {
+        if (pattern.m_nameAppendSeqNum) {
+          *pattern.m_nameAppendSeqNum += m_id;
+        }
+      }
+      indexPatterns();
+    }
+
+    /**
+     * \brief Rebuilds m_patternsByPrefix, whenever m_trafficPatterns changes.
+     *
+     * Of several patterns with the same Name, the first one that has not been removed wins.
+     */
+    void
+    indexPatterns()
+    {
+      m_patternsByPrefix.clear();
+      m_maxPrefixLength = 0;
+      for (std::size_t id = 0; id < m_trafficPatterns.size(); id++) {
+        const auto& pattern = m_trafficPatterns[id];
+        auto [it, isNew] = m_patternsByPrefix.emplace(pattern.m_prefix, id);
+        if (!isNew && m_trafficPatterns[it->second].m_isRemoved && !pattern.m_isRemoved) {
+          it->second = id;
+        }
+        m_maxPrefixLength = std::max(m_maxPrefixLength, pattern.m_prefix.size());
+      }
+    }
+
+    /**
+     * \brief Returns the process-wide unique ID of the n-th Interest sent by this worker.
+     */
+    uint64_t
+    getGlobalId(uint64_t n) const
+    {
+      return (n - 1) * m_nWorkers + m_id + 1;
+    }
+
+    /**
+     * \brief Returns whether all Interests have been sent and none of them is still pending.
+     */
+    bool
+    isFinished() const
+    {
+      return m_nMaximumInterests && m_stats.m_nInterestsSent >= *m_nMaximumInterests &&
+             m_nOutstanding == 0;
+    }
+
+  public:
+    NdnTrafficClient* const m_client; ///< lets the Face callbacks capture the worker only
+    const std::size_t m_id;
+    const std::size_t m_nWorkers;
+
+  private:
+    std::unique_ptr<boost::asio::io_context> m_ownIo;
+
+  public:
+    boost::asio::io_context& m_io;
+    std::unique_ptr<ndn::Face> m_face;
+    boost::asio::steady_timer m_timer{m_io};
+    std::chrono::steady_clock::time_point m_startTime;
+    std::chrono::steady_clock::time_point m_nextSendTime;
+    std::chrono::steady_clock::time_point m_firstSendTime;
+    std::chrono::steady_clock::time_point m_lastSendTime;
+
+    std::vector<InterestTrafficConfiguration> m_trafficPatterns;
+    std::unordered_map<ndn::Name, std::size_t> m_patternsByPrefix; ///< see indexPatterns()
+    std::size_t m_maxPrefixLength = 0;
+    AliasTable m_patternSelector;
+    double m_totalTrafficPercentage = 0.0;
+    NonceHistory m_nonces;
+    std::optional<uint64_t> m_nMaximumInterests;
+    TrafficStatistics m_stats;
+    TrafficStatistics m_intervalStats; ///< reset at every --report-interval
+    uint64_t m_nOutstanding = 0; ///< Interests neither answered nor timed out
+    std::optional<std::size_t> m_nMaximumOutstanding; ///< this worker's share of --max-outstanding
+    OutstandingTable m_outstanding;
+    boost::asio::steady_timer m_expiryTimer{m_io}; ///< --timeout only
+    uint64_t m_nextExpirySeq = 1;
+    bool m_isExpiryTimerArmed = false;
+    std::unique_ptr<trace::TraceWriter::Buffer> m_trace; ///< null unless tracing is enabled
+
+    /**
+     * \brief Sending schedule of a pattern that has its own ArrivalProcess.
+     *
+     * Such patterns do not take part in the random selection on the shared schedule and
+     * are instead sent at their share of the overall rate.
+     */
+    class PatternSchedule
+    {
+    public:
+      std::size_t m_patternId;
+      std::chrono::nanoseconds m_interval;
+      std::chrono::steady_clock::time_point m_nextSendTime;
+    };
+    std::vector<PatternSchedule> m_patternSchedules;
+
+    /**
+     * \brief Progress of the fetch of one segmented object (SegmentWindow only).
+     */
+    class ObjectFetch
+    {
+    public:
+      std::size_t m_patternId = 0;
+      ndn::Name m_name; ///< without the segment number
+      std::chrono::steady_clock::time_point m_startTime;
+      bool m_isFinalBlockKnown = false; ///< only segment 0 is requested until then
+      uint64_t m_nSegments = 1;
+      uint64_t m_nextSegment = 1;
+      uint64_t m_nReceivedSegments = 0;
+      uint64_t m_nPendingSegments = 0;
+      uint64_t m_nBytes = 0;
+      bool m_hasFailed = false;
+    };
+    std::unordered_map<uint64_t, ObjectFetch> m_objectFetches; ///< by object ID
+    uint64_t m_nObjectsStarted = 0;
+    std::chrono::steady_clock::time_point m_lastObjectTime;
+
+    // window mode state
+    double m_window = 0.0;
+    uint64_t m_recoveryPoint = 0; ///< no window decrease for Interests up to this GlobalID
+  };
+
+  void
+  mergeStatistics()
+  {
+    for (const auto& worker : m_workers) {
+      m_stats.merge(worker->m_stats);
+      // a worker may have stopped before it could apply the last reload
+      auto nPatterns = std::min(m_trafficPatterns.size(), worker->m_trafficPatterns.size());
+      for (std::size_t patternId = 0; patternId < nPatterns; patternId++) {
+        m_trafficPatterns[patternId].m_stats.merge(worker->m_trafficPatterns[patternId].m_stats);
+      }
+    }
+  }
+
+  /**
+   * \brief Returns the aggregate sending rate of all workers, in Interests per second.
+   */
+  double
+  getAchievedRate() const
+  {
+    double rate = m_agentAchievedRate;
+    for (const auto& worker : m_workers) {
+      auto n = worker->m_stats.m_nInterestsSent;
+      std::chrono::duration<double> elapsed = worker->m_lastSendTime - worker->m_firstSendTime;
+      if (n > 1 && elapsed.count() > 0) {
+        rate += (n - 1) / elapsed.count();
+      }
+    }
+    return rate;
+  }
+
+  /**
+   * \brief Returns the aggregate rate at which the workers completed objects, in MB/s.
+   */
+  double
+  getObjectGoodput() const
+  {
+    double goodput = m_agentGoodput;
+    for (const auto& worker : m_workers) {
+      std::chrono::duration<double> elapsed = worker->m_lastObjectTime - worker->m_firstSendTime;
+      if (worker->m_stats.m_nObjectsCompleted > 0 && elapsed.count() > 0) {
+        goodput += worker->m_stats.m_nObjectBytes / 1e6 / elapsed.count();
+      }
+    }
+    return goodput;
+  }
+
+  void
+  logStatistics()
+  {
+    using std::to_string;
+
+    m_logger.log("\n\n== Traffic Report ==\n", false, true);
+    m_logger.log("Total Traffic Pattern Types = " + to_string(m_trafficPatterns.size()), false, true);
+    if (m_nAgents > 0) {
+      m_logger.log("Total Agents                = " + to_string(m_nAgents), false, true);
+      m_logger.log("Achieved Interest Rate      = " + to_string(getAchievedRate()) + "/s", false, true);
+    }
+    if (m_workers.size() > 1) {
+      m_logger.log("Total Generator Threads     = " + to_string(m_workers.size()), false, true);
+    }
+    if (!m_workers.empty()) {
+      if (!m_interestWindow && !m_replayReader && m_arrivalProcess.getType() != ArrivalProcess::Type::ON_OFF &&
+          m_arrivalProcess.getType() != ArrivalProcess::Type::RAMP) {
+        auto targetRate = 1e9 / m_interestInterval.count() * m_workers.size();
+        m_logger.log("Target Interest Rate        = " + to_string(targetRate) + "/s", false, true);
+      }
+      m_logger.log("Achieved Interest Rate      = " + to_string(getAchievedRate()) + "/s", false, true);
+    }
+    if (!m_workers.empty()) {
+      uint64_t nOutstanding = 0;
+      for (const auto& worker : m_workers) {
+        nOutstanding += worker->m_nOutstanding;
+      }
+      m_logger.log("Interests Still In Flight   = " + to_string(nOutstanding), false, true);
+    }
+    if (m_interestWindow && m_isWindowAdaptive) {
+      double window = 0.0;
+      for (const auto& worker : m_workers) {
+        window += worker->m_window;
+      }
+      m_logger.log("Final Interest Window       = " + to_string(window), false, true);
+    }
+    if (m_replayReader) {
+      m_logger.log("Replayed Interests Skipped  = " + to_string(m_nReplaySkipped), false, true);
+      if (m_replayReader->getFormat() == ReplayReader::Format::PCAP) {
+        m_logger.log("Non-NDN Frames Skipped      = " + to_string(m_replayReader->getSkippedFrames()),
+                     false, true);
+      }
+      else if (m_replayReader->getLateRecords() > 0) {
+        m_logger.log("Replayed Interests Late     = " + to_string(m_replayReader->getLateRecords()),
+                     false, true);
+      }
+    }
+    if (m_transportOptions.m_batchPolicy) {
+      m_logger.log("Average Batch Size          = " + to_string(getBatchStatistics(m_workers).getAverageBatchSize()),
+                   false, true);
+    }
+    m_logger.log("Peak Resident Memory        = " + to_string(getPeakResidentMemory() >> 20) + "MiB", false, true);
+    if (m_stats.m_nObjectsCompleted > 0) {
+      m_logger.log("Object Goodput              = " + to_string(getObjectGoodput()) + "MB/s", false, true);
+    }
+    m_stats.log(m_logger);
+
+    for (std::size_t patternId = 0; patternId < m_trafficPatterns.size() && !m_wantBrief; patternId++) {
+      const auto& pattern = m_trafficPatterns[patternId];
+
+      m_logger.log("Traffic Pattern Type #" + to_string(patternId + 1) + (pattern.m_isRemoved ? " (removed)" : ""),
+                   false, true);
+      pattern.printTrafficConfiguration(m_logger);
+      pattern.m_stats.log(m_logger);
+    }
+  }
+
+  /**
+   * \brief Distributes the traffic among the agents and reports their aggregate statistics.
+   */
+  int
+  runController()
+  {
+    if (!readConfigurationFile(m_configurationFile, m_trafficPatterns, m_logger)) {
+      return 2;
+    }
+    if (!checkTrafficPatternCorrectness(m_trafficPatterns)) {
+      m_logger.log("ERROR: Traffic configuration provided is not proper", false, true);
+      return 2;
+    }
+    // the agents parse the same text, so that a pattern id means the same pattern everywhere
+    std::string configuration(MappedFile(m_configurationFile).getContents());
+
+    std::string error;
+    std::vector<coordination::Message> results;
+    std::unique_ptr<coordination::Controller> controller;
+    try {
+      controller = std::make_unique<coordination::Controller>(m_io, *m_agentsEndpoint, m_nAgents,
+        [&] (std::size_t agentId, auto startTime) { return makeAssignment(agentId, startTime, configuration); },
+        [this] (std::size_t agentId, const auto& remote) {
+          m_logger.log("Agent #" + std::to_string(agentId + 1) + " connected from " +
+                       boost::lexical_cast<std::string>(remote), true, false);
+        },
+        [&] (const std::string& what, auto agentResults) {
+          error = what;
+          results = std::move(agentResults);
+          m_signalSet.cancel();
+        });
+    }
+    catch (const std::exception& e) {
+      m_logger.log("ERROR: cannot listen for agents: "s + e.what(), false, true);
+      return 2;
+    }
+
+    m_logger.log("Waiting for " + std::to_string(m_nAgents) + " agents on " +
+                 boost::lexical_cast<std::string>(*m_agentsEndpoint), true, true);
+    m_signalSet.async_wait([this] (const boost::system::error_code& ec, int) {
+      if (ec != boost::asio::error::operation_aborted) {
+        m_io.stop();
+      }
+    });
+    m_io.run();
+
+    if (results.empty()) {
+      m_logger.log("ERROR: " + (error.empty() ? "interrupted"s : error), false, true);
+      return 1;
+    }
+
+    for (std::size_t agentId = 0; agentId < results.size(); agentId++) {
+      try {
+        mergeAgentResult(results[agentId]);
+      }
+      catch (const std::exception& e) {
+        m_logger.log("ERROR: invalid result from agent #" + std::to_string(agentId + 1) + ": " + e.what(),
+                     false, true);
+        return 1;
+      }
+    }
+    if (m_stats.m_nContentInconsistencies > 0 || m_stats.m_nSignatureFailures > 0 ||
+        m_stats.m_nInterestsSent != m_stats.m_nInterestsReceived) {
+      m_hasError = true;
+    }
+    logStatistics();
+    return m_hasError ? 1 : 0;
+  }
+
+  /**
+   * \brief Returns the messages that the controller sends to agent \p agentId.
+   *
+   * `--count` and `--window` are split among the agents as each agent splits its share among
+   * its workers; the other options are given to every agent on its own command line.
+   */
+  std::vector<coordination::Message>
+  makeAssignment(std::size_t agentId, coordination::Controller::Clock::time_point startTime,
+                 const std::string& configuration) const
+  {
+    using std::to_string;
+
+    std::string assignment = "Agent=" + to_string(agentId + 1) + "\n";
+    if (m_nMaximumInterests) {
+      assignment += "Count=" + to_string(*m_nMaximumInterests / m_nAgents +
+                                         (agentId < *m_nMaximumInterests % m_nAgents)) + "\n";
+    }
+    if (m_interestWindow) {
+      assignment += "Window=" + to_string(*m_interestWindow / m_nAgents + (agentId < *m_interestWindow % m_nAgents)) +
+                    "\nAdaptiveWindow=" + (m_isWindowAdaptive ? "1" : "0") + "\n";
+    }
+    auto nsSinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(startTime.time_since_epoch());
+    assignment += "StartTime=" + to_string(nsSinceEpoch.count()) + "\n";
+
+    return {{"CONFIG", configuration}, {"ASSIGN", std::move(assignment)}};
+  }
+
+  /**
+   * \brief Adds the statistics in a RESULT message of an agent to those of the controller.
+   * \throw std::invalid_argument
+   */
+  void
+  mergeAgentResult(const coordination::Message& result)
+  {
+    if (result.m_type != "RESULT") {
+      throw std::invalid_argument("unexpected message " + result.m_type);
+    }
+
+    std::istringstream is(result.m_body);
+    int exitCode = 0;
+    double achievedRate = 0.0;
+    double goodput = 0.0;
+    std::size_t nPatterns = 0;
+    if (!(is >> exitCode >> achievedRate >> goodput >> nPatterns)) {
+      throw std::invalid_argument("truncated result");
+    }
+    if (exitCode != 0) {
+      m_logger.log("ERROR: An agent exited with code " + std::to_string(exitCode), false, true);
+      m_hasError = true;
+    }
+
+    m_stats.merge(TrafficStatistics::load(is));
+    for (std::size_t patternId = 0; patternId < nPatterns; patternId++) {
+      auto stats = TrafficStatistics::load(is);
+      if (patternId < m_trafficPatterns.size()) {
+        m_trafficPatterns[patternId].m_stats.merge(stats);
+      }
+    }
+    m_agentAchievedRate += achievedRate;
+    m_agentGoodput += goodput;
+  }
+
+  /**
+   * \brief Connects to the controller and waits for the configuration and the assignment.
+   * \return whether the assignment has been received
+   */
+  bool
+  receiveAssignment()
+  {
+    m_logger.log("Waiting for the assignment of the controller at " +
+                 boost::lexical_cast<std::string>(*m_controllerEndpoint), true, true);
+
+    std::string error;
+    std::optional<std::string> assignment;
+    m_controller = std::make_unique<coordination::Connection>(boost::asio::ip::tcp::socket(m_io));
+    auto finish = [&] (std::string what) {
+      // keep the first error: closing the connection aborts the pending receive
+      if (error.empty()) {
+        error = std::move(what);
+      }
+      m_signalSet.cancel();
+      if (!assignment) {
+        m_controller->close();
+      }
+    };
+    std::function<void()> receive = [&] {
+      m_controller->asyncReceive([&] (const boost::system::error_code& ec, coordination::Message message) {
+        if (ec) {
+          finish("lost the connection to the controller: " + ec.message());
+        }
+        else if (message.m_type == "CONFIG") {
+          m_configurationText = std::move(message.m_body);
+          receive();
+        }
+        else if (message.m_type == "ASSIGN") {
+          assignment = std::move(message.m_body);
+          finish("");
+        }
+        else {
+          finish("unexpected message " + message.m_type + " from the controller");
+        }
+      });
+    };
+
+    m_controller->getSocket().async_connect(*m_controllerEndpoint, [&] (const boost::system::error_code& ec) {
+      if (ec) {
+        finish("cannot connect to the controller: " + ec.message());
+        return;
+      }
+      receive();
+    });
+    m_signalSet.async_wait([&] (const boost::system::error_code& ec, int) {
+      if (ec != boost::asio::error::operation_aborted) {
+        finish("interrupted");
+      }
+    });
+    // any handler left after an error or a signal only sees operation_aborted
+    m_io.run();
+    m_io.restart();
+
+    if (!assignment || !m_configurationText) {
+      m_logger.log("ERROR: " + (error.empty() ? "no configuration from the controller"s : error), false, true);
+      return false;
+    }
+
+    try {
+      applyAssignment(*assignment);
+    }
+    catch (const std::exception& e) {
+      m_logger.log("ERROR: invalid assignment from the controller: "s + e.what(), false, true);
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * \throw std::invalid_argument
+   * \throw std::out_of_range
+   */
+  void
+  applyAssignment(std::string_view contents)
+  {
+    while (!contents.empty()) {
+      auto endOfLine = contents.find('\n');
+      auto line = contents.substr(0, endOfLine);
+      contents.remove_prefix(endOfLine == std::string_view::npos ? contents.size() : endOfLine + 1);
+      std::string_view parameter;
+      std::string_view value;
+      if (!extractParameterAndValue(line, parameter, value)) {
+        continue;
+      }
+      if (parameter == "Count") {
+        m_nMaximumInterests = std::stoull(std::string(value));
+      }
+      else if (parameter == "Window") {
+        m_interestWindow = std::stoull(std::string(value));
+      }
+      else if (parameter == "AdaptiveWindow") {
+        m_isWindowAdaptive = value == "1";
+      }
+      else if (parameter == "StartTime") {
+        m_startTime = coordination::Controller::Clock::time_point(
+                        std::chrono::duration_cast<coordination::Controller::Clock::duration>(
+                          std::chrono::nanoseconds(std::stoll(std::string(value)))));
+      }
+      else if (parameter == "Agent") {
+        m_logger.log("Running as agent #" + std::string(value), true, true);
+      }
+    }
+    if (m_interestWindow == 0u) {
+      throw std::invalid_argument("empty window");
+    }
+  }
+
+  /**
+   * \brief Sends the statistics of this agent to the controller.
+   */
+  void
+  sendResult(int exitCode)
+  {
+    std::ostringstream os;
+    os << exitCode << ' ' << std::setprecision(17) << getAchievedRate() << ' ' << getObjectGoodput() << ' '
+       << m_trafficPatterns.size() << '\n';
+    m_stats.save(os);
+    for (const auto& pattern : m_trafficPatterns) {
+      pattern.m_stats.save(os);
+    }
+
+    try {
+      m_controller->send({"RESULT", os.str()});
+    }
+    catch (const std::exception& e) {
+      m_logger.log("ERROR: cannot send the results to the controller: "s + e.what(), false, true);
+    }
+    m_controller->close();
+  }
+
+  bool
+  checkTrafficPatternCorrectness(std::vector<InterestTrafficConfiguration>& patterns)
+  {
+    if (patterns.empty()) {
+      m_logger.log("ERROR: No valid traffic pattern found", false, true);
+      return false;
+    }
+
+    for (std::size_t i = 0; i < patterns.size(); i++) {
+      try {
+        patterns[i].prepareInterestTemplate();
+      }
+      catch (const std::exception& e) {
+        m_logger.log("ERROR: Traffic Pattern Type #" + std::to_string(i + 1) + " has an invalid Name: " +
+                     patterns[i].m_name + " (" + e.what() + ")", false, true);
+        return false;
+      }
+    }
+
+    // the same prefix may legitimately be used with different parameters, so only warn
+    std::unordered_map<ndn::Name, std::size_t> firstUse;
+    for (std::size_t i = 0; i < patterns.size(); i++) {
+      auto [it, isNew] = firstUse.emplace(patterns[i].m_prefix, i);
+      if (!isNew) {
+        m_logger.log("WARNING: Traffic Pattern Type #" + std::to_string(i + 1) + " has the same Name as #" +
+                     std::to_string(it->second + 1) + ": " + patterns[i].m_name, false, true);
+      }
+    }
+
+    double totalTrafficPercentage = 0.0;
+    for (const auto& pattern : patterns) {
+      totalTrafficPercentage += std::max(0.0, pattern.m_trafficPercentage);
+    }
+    if (totalTrafficPercentage > 0.0 && std::abs(totalTrafficPercentage - 100.0) > 1e-6) {
+      m_logger.log("WARNING: TrafficPercentage values add up to " + std::to_string(totalTrafficPercentage) +
+                   ", they will be scaled to add up to 100", false, true);
+    }
+    return true;
+  }
+
+  /**
+   * \brief Builds the pattern selector from the percentages of the current traffic patterns.
+   */
+  void
+  updateTrafficMix()
+  {
+    std::vector<double> weights;
+    m_totalTrafficPercentage = 0.0;
+    for (const auto& pattern : m_trafficPatterns) {
+      double weight = pattern.m_isRemoved ? 0.0 : pattern.m_trafficPercentage;
+      weights.push_back(weight);
+      m_totalTrafficPercentage += std::max(0.0, weight);
+    }
+    m_patternSelector = AliasTable(weights);
+  }
+
+  void
+  waitForReload()
+  {
+    m_reloadSignalSet.async_wait([this] (const boost::system::error_code& ec, int) {
+      if (!ec) {
+        reloadConfiguration();
+        waitForReload();
+      }
+    });
+  }
+
+  /**
+   * \brief Re-reads the configuration file and hands the new traffic patterns to the workers.
+   *
+   * A pattern keeps its number, and its statistics, as long as a pattern with the same Name
+   * is configured; if several patterns have the same Name, they are matched in order.
+   * Patterns that disappear from the file stop generating traffic, but remain in the reports
+   * so that the Interests they sent are still accounted for. New patterns are numbered after
+   * all existing ones. If the new configuration is invalid, the current one stays in effect.
+   */
+  void
+  reloadConfiguration()
+  {
+    m_logger.log("Reloading traffic configuration file " + m_configurationFile, true, true);
+
+    std::vector<InterestTrafficConfiguration> patterns;
+    if (!readConfigurationFile(m_configurationFile, patterns, m_logger) ||
+        !checkTrafficPatternCorrectness(patterns)) {
+      m_logger.log("ERROR: Traffic configuration provided is not proper, keeping the current one", true, true);
+      return;
+    }
+
+    std::unordered_map<ndn::Name, std::deque<std::size_t>> ids;
+    for (std::size_t id = 0; id < m_trafficPatterns.size(); id++) {
+      ids[m_trafficPatterns[id].m_prefix].push_back(id);
+    }
+
+    auto updated = m_trafficPatterns;
+    for (auto& pattern : updated) {
+      pattern.m_isRemoved = true;
+    }
+    std::size_t nAdded = 0;
+    for (auto& pattern : patterns) {
+      auto it = ids.find(pattern.m_prefix);
+      if (it == ids.end() || it->second.empty()) {
+        updated.push_back(std::move(pattern));
+        nAdded++;
+      }
+      else {
+        updated[it->second.front()] = std::move(pattern);
+        it->second.pop_front();
+      }
+    }
+
+    double totalTrafficPercentage = 0.0;
+    for (const auto& pattern : updated) {
+      if (!pattern.m_isRemoved) {
+        totalTrafficPercentage += std::max(0.0, pattern.m_trafficPercentage);
+      }
+    }
+    if (m_interestWindow && totalTrafficPercentage <= 0.0) {
+      m_logger.log("ERROR: Window mode requires at least one pattern with a positive TrafficPercentage, "
+                   "keeping the current configuration", true, true);
+      return;
+    }
+
+    std::size_t nRemoved = 0;
+    for (std::size_t id = 0; id < m_trafficPatterns.size(); id++) {
+      nRemoved += !m_trafficPatterns[id].m_isRemoved && updated[id].m_isRemoved;
+    }
+    m_trafficPatterns = std::move(updated);
+    updateTrafficMix();
+
+    m_logger.log("Traffic configuration reloaded - Patterns=" + std::to_string(patterns.size()) +
+                 ", Added=" + std::to_string(nAdded) + ", Removed=" + std::to_string(nRemoved), true, true);
+    for (std::size_t id = 0; id < m_trafficPatterns.size() && !m_wantBrief; id++) {
+      if (!m_trafficPatterns[id].m_isRemoved) {
+        m_logger.log("Traffic Pattern Type #" + std::to_string(id + 1), false, false);
+        m_trafficPatterns[id].printTrafficConfiguration(m_logger);
+      }
+    }
+
+    auto snapshot = std::make_shared<const std::vector<InterestTrafficConfiguration>>(m_trafficPatterns);
+    for (auto& worker : m_workers) {
+      boost::asio::post(worker->m_io, [this, snapshot, selector = m_patternSelector,
+                                       total = m_totalTrafficPercentage, &worker = *worker] {
+        applyConfiguration(worker, *snapshot, selector, total);
+      });
+    }
+  }
+
+  /**
+   * \brief Installs a reloaded configuration, on the worker's own thread.
+   *
+   * Existing patterns keep their statistics, so that Interests sent before the reload are
+   * accounted for as usual, and their sequence numbers continue from the current value.
+   */
+  void
+  applyConfiguration(Worker& worker, const std::vector<InterestTrafficConfiguration>& patterns,
+                     const AliasTable& selector, double totalTrafficPercentage)
+  {
+    auto old = std::exchange(worker.m_trafficPatterns, patterns);
+    for (std::size_t id = 0; id < worker.m_trafficPatterns.size(); id++) {
+      auto& pattern = worker.m_trafficPatterns[id];
+      if (id < old.size()) {
+        pattern.m_stats = std::move(old[id].m_stats);
+        if (pattern.m_nameAppendSeqNum && old[id].m_nameAppendSeqNum) {
+          pattern.m_nameAppendSeqNum = old[id].m_nameAppendSeqNum;
+          continue;
+        }
+      }
+      if (pattern.m_nameAppendSeqNum) {
+        *pattern.m_nameAppendSeqNum += worker.m_id;
+      }
+    }
+    worker.indexPatterns();
+    worker.m_patternSelector = selector;
+    worker.m_totalTrafficPercentage = totalTrafficPercentage;
+
+    if (m_interestWindow) {
+      fillWindow(worker);
+      return;
+    }
+    if (m_replayReader ||
+        (worker.m_nMaximumInterests && worker.m_stats.m_nInterestsSent >= *worker.m_nMaximumInterests)) {
+      return;
+    }
+    updatePatternSchedules(worker, std::chrono::steady_clock::now());
+    scheduleNextWakeup(worker);
+  }
+
+  static uint32_t
+  getNewNonce(NonceHistory& nonces)
+  {
+    auto randomNonce = ndn::random::generateWord32();
+    while (nonces.contains(randomNonce))
+      randomNonce = ndn::random::generateWord32();
+
+    nonces.insert(randomNonce);
+    return randomNonce;
+  }
+
+  static uint32_t
+  getOldNonce(NonceHistory& nonces)
+  {
+    if (nonces.empty())
+      return getNewNonce(nonces);
+
+    return nonces.sample(ndn::random::getRandomNumberEngine());
+  }
+
+  static auto
+  generateRandomNameComponent(std::size_t length)
+  {
+    auto& rng = ndn::random::getRandomNumberEngine();
+
+    // fill the buffer one random word at a time, rather than one byte at a time
+    ndn::Buffer buf(length);
+    for (std::size_t i = 0; i < length; i += sizeof(uint32_t)) {
+      auto word = static_cast<uint32_t>(rng());
+      std::memcpy(buf.data() + i, &word, std::min(sizeof(word), length - i));
+    }
+    return ndn::name::Component(buf);
+  }
+
+  static auto
+  prepareInterest(Worker& worker, std::size_t patternId)
+  {
+    NDNTG_PROFILE("prepareInterest");
+    auto& pattern = worker.m_trafficPatterns[patternId];
+    ndn::Interest interest(pattern.m_interestTemplate);
+
+    if (pattern.m_nameDistribution || pattern.m_nameAppendBytes > 0 || pattern.m_nameAppendSeqNum) {
+      ndn::Name name(pattern.m_prefix);
+      if (pattern.m_nameDistribution) {
+        auto k = pattern.m_nameDistribution->sample(ndn::random::getRandomNumberEngine());
+        name.append(pattern.getCatalogueComponent(k));
+      }
+      if (pattern.m_nameAppendBytes > 0) {
+        name.append(generateRandomNameComponent(*pattern.m_nameAppendBytes));
+      }
+      if (pattern.m_nameAppendSeqNum) {
+        auto seqNum = *pattern.m_nameAppendSeqNum;
+        name.appendSequenceNumber(seqNum);
+        pattern.m_nameAppendSeqNum = seqNum + worker.m_nWorkers;
+      }
+      interest.setName(name);
+    }
+
+    std::uniform_int_distribution<unsigned> duplicateNonceDist(1, 100);
+    if (duplicateNonceDist(ndn::random::getRandomNumberEngine()) <= pattern.m_nonceDuplicationPercentage)
+      interest.setNonce(getOldNonce(worker.m_nonces));
+    else
+      interest.setNonce(getNewNonce(worker.m_nonces));
+
+    return interest;
+  }
+
+  static void
+  traceEvent(Worker& worker, trace::EventType type, uint64_t seq, const OutstandingTable::Entry& entry,
+             std::chrono::steady_clock::time_point receiveTime = {}, uint32_t nackReason = 0)
+  {
+    auto toNanoseconds = [] (std::chrono::steady_clock::time_point tp) {
+      return static_cast<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count());
+    };
+
+    trace::TraceRecord record;
+    record.m_type = type;
+    record.m_patternId = static_cast<uint32_t>(entry.m_patternId);
+    record.m_globalId = worker.getGlobalId(seq);
+    record.m_localId = entry.m_localRef;
+    record.m_nonce = entry.m_nonce;
+    record.m_nackReason = nackReason;
+    record.m_sendTime = toNanoseconds(entry.m_sentTime);
+    record.m_receiveTime = toNanoseconds(receiveTime);
+    worker.m_trace->append(record);
+  }
+
+  void
+  onData(Worker& worker, const ndn::Interest& interest, const ndn::Data& data, uint64_t seq)
+  {
+    NDNTG_PROFILE("onData");
+    auto now = std::chrono::steady_clock::now();
+    auto* found = worker.m_outstanding.find(seq);
+    if (found == nullptr) {
+      onEvictedLateData(worker, interest, data, seq);
+      return;
+    }
+    auto entry = *found;
+    worker.m_outstanding.erase(*found);
+
+    auto patternId = entry.m_patternId;
+    auto& pattern = worker.m_trafficPatterns[patternId];
+    auto globalRef = worker.getGlobalId(seq);
+
+    if (entry.m_hasTimedOut) {
+      worker.m_stats.m_nLateData++;
+      worker.m_intervalStats.m_nLateData++;
+      pattern.m_stats.m_nLateData++;
+      if (worker.m_trace) {
+        traceEvent(worker, trace::EventType::LATE_DATA_RECEIVED, seq, entry, now);
+      }
+      else if (!m_wantQuiet) {
+        auto logLine = "Late Data Received - PatternType=" + std::to_string(patternId + 1) +
+                       ", GlobalID=" + std::to_string(globalRef) +
+                       ", LocalID=" + std::to_string(entry.m_localRef) +
+                       ", Name=" + data.getName().toUri();
+        m_logger.log(logLine, true, false);
+      }
+      return;
+    }
+
+    worker.m_stats.m_nInterestsReceived++;
+    worker.m_intervalStats.m_nInterestsReceived++;
+    pattern.m_stats.m_nInterestsReceived++;
+
+    const char* isConsistent = "NotChecked";
+    if (pattern.hasContentCheck()) {
+      if (!pattern.isContentConsistent(data.getContent().value_bytes())) {
+        worker.m_stats.m_nContentInconsistencies++;
+        pattern.m_stats.m_nContentInconsistencies++;
+        isConsistent = "No";
+      }
+      else {
+        isConsistent = "Yes";
+      }
+    }
+
+    const char* isSignatureValid = nullptr;
+    if (pattern.hasSignatureCheck()) {
+      auto start = std::chrono::steady_clock::now();
+      bool isValid = pattern.verifySignature(data);
+      auto duration = std::chrono::steady_clock::now() - start;
+      worker.m_stats.addVerification(isValid, duration);
+      pattern.m_stats.addVerification(isValid, duration);
+      isSignatureValid = isValid ? "Yes" : "No";
+    }
+
+    auto rttNs = std::chrono::duration_cast<std::chrono::nanoseconds>(now - entry.m_sentTime);
+    double rtt = rttNs.count() / 1e6;
+    worker.m_stats.addRoundTripTime(rttNs);
+    worker.m_intervalStats.addRoundTripTime(rttNs);
+    pattern.m_stats.addRoundTripTime(rttNs);
+
+    if (worker.m_trace) {
+      traceEvent(worker, trace::EventType::DATA_RECEIVED, seq, entry, now);
+    }
+    else {
+      if (!m_wantQuiet) {
+        auto logLine = "Data Received      - PatternType=" + std::to_string(patternId + 1) +
+                       ", GlobalID=" + std::to_string(globalRef) +
+                       ", LocalID=" + std::to_string(entry.m_localRef) +
+                       ", Name=" + data.getName().toUri() +
+                       ", IsConsistent=" + isConsistent;
+        if (isSignatureValid != nullptr) {
+          logLine += ", IsSignatureValid="s + isSignatureValid;
+        }
+        m_logger.log(logLine, true, false);
+      }
+      if (m_wantVerbose) {
+        auto rttLine = "RTT                - Name=" + data.getName().toUri() +
+                       ", RTT=" + std::to_string(rtt) + "ms";
+        m_logger.log(rttLine, true, false);
+      }
+    }
+
+    if (entry.m_objectId != 0) {
+      onSegmentCompleted(worker, entry.m_objectId, &data);
+    }
+    onInterestCompleted(worker, globalRef, false);
+  }
+
+  void
+  onNack(Worker& worker, const ndn::Interest& interest, const ndn::lp::Nack& nack, uint64_t seq)
+  {
+    auto* found = worker.m_outstanding.find(seq);
+    if (found == nullptr) {
+      // evicted, and already accounted for as a timeout
+      return;
+    }
+    auto entry = *found;
+    worker.m_outstanding.erase(*found);
+    if (entry.m_hasTimedOut) {
+      // already accounted for as a timeout
+      return;
+    }
+
+    auto patternId = entry.m_patternId;
+    auto globalRef = worker.getGlobalId(seq);
+    if (worker.m_trace) {
+      traceEvent(worker, trace::EventType::NACK_RECEIVED, seq, entry, std::chrono::steady_clock::now(),
+                 static_cast<uint32_t>(nack.getReason()));
+    }
+    else {
+      auto logLine = "Interest Nack'd    - PatternType=" + std::to_string(patternId + 1) +
+                     ", GlobalID=" + std::to_string(globalRef) +
+                     ", LocalID=" + std::to_string(entry.m_localRef) +
+                     ", Name=" + interest.getName().toUri() +
+                     ", NackReason=" + boost::lexical_cast<std::string>(nack.getReason());
+      m_logger.log(logLine, true, false);
+    }
+
+    worker.m_stats.m_nNacks++;
+    worker.m_intervalStats.m_nNacks++;
+    worker.m_trafficPatterns[patternId].m_stats.m_nNacks++;
+
+    if (entry.m_objectId != 0) {
+      onSegmentCompleted(worker, entry.m_objectId, nullptr);
+    }
+    onInterestCompleted(worker, globalRef, true);
+  }
+
+  void
+  onTimeout(Worker& worker, const ndn::Interest& interest, uint64_t seq)
+  {
+    auto* found = worker.m_outstanding.find(seq);
+    if (found == nullptr) {
+      // evicted, and already accounted for as a timeout
+      return;
+    }
+    auto entry = *found;
+    worker.m_outstanding.erase(*found);
+    if (!entry.m_hasTimedOut) {
+      countTimeout(worker, seq, entry, interest.getName().toUri());
+    }
+  }
+
+  /**
+   * \brief Counts late Data whose entry has been evicted from the OutstandingTable.
+   *
+   * The traffic pattern is found again from the name; the send time is lost, so the Data
+   * is neither traced nor given an RTT.
+   */
+  void
+  onEvictedLateData(Worker& worker, const ndn::Interest& interest, const ndn::Data& data, uint64_t seq)
+  {
+    worker.m_stats.m_nLateData++;
+    worker.m_intervalStats.m_nLateData++;
+    auto patternId = findPattern(worker, interest.getName(), true);
+    if (patternId) {
+      worker.m_trafficPatterns[*patternId].m_stats.m_nLateData++;
+    }
+    if (!m_wantQuiet && !worker.m_trace) {
+      auto logLine = "Late Data Received - PatternType=" + (patternId ? std::to_string(*patternId + 1) : "?"s) +
+                     ", GlobalID=" + std::to_string(worker.getGlobalId(seq)) +
+                     ", Name=" + data.getName().toUri();
+      m_logger.log(logLine, true, false);
+    }
+  }
+
+  /**
+   * \brief Returns the traffic pattern of \p worker with the longest Name that is a prefix
+   *        of \p name.
+   *
+   * The prefixes of \p name are looked up in Worker::m_patternsByPrefix, from the longest one.
+   * \param wantRemoved whether patterns removed by a reload can match
+   */
+  static std::optional<std::size_t>
+  findPattern(const Worker& worker, const ndn::Name& name, bool wantRemoved)
+  {
+    for (auto k = std::min(name.size(), worker.m_maxPrefixLength) + 1; k-- > 0;) {
+      auto it = worker.m_patternsByPrefix.find(name.getPrefix(static_cast<ssize_t>(k)));
+      if (it != worker.m_patternsByPrefix.end() &&
+          (wantRemoved || !worker.m_trafficPatterns[it->second].m_isRemoved)) {
+        return it->second;
+      }
+    }
+    return std::nullopt;
+  }
+
+  void
+  countTimeout(Worker& worker, uint64_t seq, const OutstandingTable::Entry& entry, const std::string& name)
+  {
+    auto patternId = entry.m_patternId;
+    auto globalRef = worker.getGlobalId(seq);
+    if (worker.m_trace) {
+      traceEvent(worker, trace::EventType::TIMEOUT, seq, entry, std::chrono::steady_clock::now());
+    }
+    else {
+      auto logLine = "Interest Timed Out - PatternType=" + std::to_string(patternId + 1) +
+                     ", GlobalID=" + std::to_string(globalRef) +
+                     ", LocalID=" + std::to_string(entry.m_localRef);
+      if (!name.empty()) {
+        logLine += ", Name=" + name;
+      }
+      m_logger.log(logLine, true, false);
+    }
+
+    worker.m_stats.m_nTimeouts++;
+    worker.m_intervalStats.m_nTimeouts++;
+    worker.m_trafficPatterns[patternId].m_stats.m_nTimeouts++;
+
+    if (entry.m_objectId != 0) {
+      onSegmentCompleted(worker, entry.m_objectId, nullptr);
+    }
+    onInterestCompleted(worker, globalRef, true);
+  }
+
+  /**
+   * \brief Counts as timed out the Interests that have been pending for longer than `--timeout`.
+   *
+   * They stay in the OutstandingTable until the Face reports their outcome or their slot is
+   * needed, so that Data arriving after the deadline can be recognized as late.
+   */
+  void
+  expireInterests(Worker& worker)
+  {
+    worker.m_isExpiryTimerArmed = false;
+    auto now = std::chrono::steady_clock::now();
+    // Interests are sent in sequence number order, so they also expire in this order
+    for (; worker.m_nextExpirySeq <= worker.m_stats.m_nInterestsSent; worker.m_nextExpirySeq++) {
+      auto seq = worker.m_nextExpirySeq;
+      auto* entry = worker.m_outstanding.find(seq);
+      if (entry == nullptr || entry->m_hasTimedOut) {
+        continue;
+      }
+
+      auto deadline = entry->m_sentTime + *m_timeout;
+      if (deadline > now) {
+        armExpiryTimer(worker, deadline);
+        return;
+      }
+      entry->m_hasTimedOut = true;
+      countTimeout(worker, seq, *entry, "");
+    }
+  }
+
+  void
+  armExpiryTimer(Worker& worker, std::chrono::steady_clock::time_point deadline)
+  {
+    worker.m_isExpiryTimerArmed = true;
+    worker.m_expiryTimer.expires_at(deadline);
+    worker.m_expiryTimer.async_wait([this, &worker] (const boost::system::error_code& ec) {
+      if (!ec) {
+        expireInterests(worker);
+      }
+    });
+  }
+
+  void
+  onInterestCompleted(Worker& worker, uint64_t globalRef, bool isCongestionSignal)
+  {
+    worker.m_nOutstanding--;
+
+    if (m_interestWindow) {
+      if (m_isWindowAdaptive) {
+        if (!isCongestionSignal) {
+          // additive increase: about one Interest per round trip
+          worker.m_window += 1.0 / worker.m_window;
+          if (worker.m_nMaximumOutstanding) {
+            worker.m_window = std::min(worker.m_window, static_cast<double>(*worker.m_nMaximumOutstanding));
+          }
+        }
+        else if (globalRef > worker.m_recoveryPoint) {
+          // multiplicative decrease, at most once per window
+          worker.m_window = std::max(1.0, worker.m_window / 2.0);
+          worker.m_recoveryPoint = worker.getGlobalId(worker.m_stats.m_nInterestsSent);
+        }
+      }
+      fillWindow(worker);
+    }
+
+    if (worker.isFinished()) {
+      onWorkerFinished();
+    }
+  }
+
+  /**
+   * \brief Picks a traffic pattern at random, according to the configured percentages.
+   */
+  static std::optional<std::size_t>
+  selectTrafficPattern(const Worker& worker)
+  {
+    return worker.m_patternSelector.sample(ndn::random::getRandomNumberEngine());
+  }
+
+  /**
+   * \brief Sends an Interest of pattern \p patternId or, for a SegmentWindow pattern, starts the
+   *        fetch of a new object by sending an Interest for its first segment.
+   */
+  bool
+  sendInterest(Worker& worker, std::size_t patternId)
+  {
+    auto interest = prepareInterest(worker, patternId);
+    if (!worker.m_trafficPatterns[patternId].m_segmentWindow) {
+      return expressInterest(worker, patternId, interest, 0);
+    }
+
+    auto objectId = ++worker.m_nObjectsStarted;
+    auto& fetch = worker.m_objectFetches[objectId];
+    fetch.m_patternId = patternId;
+    fetch.m_name = interest.getName();
+    fetch.m_startTime = std::chrono::steady_clock::now();
+    fetch.m_nPendingSegments = 1;
+    interest.setName(ndn::Name(fetch.m_name).appendSegment(0));
+    if (!expressInterest(worker, patternId, interest, objectId)) {
+      worker.m_objectFetches.erase(objectId);
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * \brief Sends the Interest for the next segment of an object.
+   */
+  bool
+  sendSegmentInterest(Worker& worker, uint64_t objectId, Worker::ObjectFetch& fetch)
+  {
+    const auto& pattern = worker.m_trafficPatterns[fetch.m_patternId];
+    ndn::Interest interest(pattern.m_interestTemplate);
+    interest.setName(ndn::Name(fetch.m_name).appendSegment(fetch.m_nextSegment));
+    interest.setNonce(getNewNonce(worker.m_nonces));
+    if (!expressInterest(worker, fetch.m_patternId, interest, objectId)) {
+      return false;
+    }
+    fetch.m_nextSegment++;
+    fetch.m_nPendingSegments++;
+    return true;
+  }
+
+  /**
+   * \brief Accounts for the outcome of a segment Interest, and keeps the pipeline of its object full.
+   * \param data the segment, or null if the Interest was Nack'd or timed out
+   *
+   * A failed segment is not retransmitted: the object is counted as failed once the segments
+   * still in flight have come back.
+   */
+  void
+  onSegmentCompleted(Worker& worker, uint64_t objectId, const ndn::Data* data)
+  {
+    auto it = worker.m_objectFetches.find(objectId);
+    if (it == worker.m_objectFetches.end()) {
+      return;
+    }
+    auto& fetch = it->second;
+    fetch.m_nPendingSegments--;
+    if (data == nullptr) {
+      fetch.m_hasFailed = true;
+    }
+    else {
+      fetch.m_nReceivedSegments++;
+      fetch.m_nBytes += data->getContent().value_size();
+      if (!fetch.m_isFinalBlockKnown) {
+        // without a FinalBlockId, the object is made of this segment only
+        fetch.m_isFinalBlockKnown = true;
+        const auto& finalBlock = data->getFinalBlock();
+        if (finalBlock && finalBlock->isSegment()) {
+          fetch.m_nSegments = finalBlock->toSegment() + 1;
+        }
+      }
+    }
+
+    auto& pattern = worker.m_trafficPatterns[fetch.m_patternId];
+    auto window = pattern.m_segmentWindow.value_or(1);
+    while (!fetch.m_hasFailed && fetch.m_isFinalBlockKnown && fetch.m_nextSegment < fetch.m_nSegments &&
+           fetch.m_nPendingSegments < window) {
+      if (!sendSegmentInterest(worker, objectId, fetch)) {
+        fetch.m_hasFailed = true;
+      }
+    }
+    if (fetch.m_nPendingSegments > 0) {
+      return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    bool isComplete = !fetch.m_hasFailed && fetch.m_nReceivedSegments == fetch.m_nSegments;
+    auto completionTime = std::chrono::duration_cast<std::chrono::nanoseconds>(now - fetch.m_startTime);
+    worker.m_stats.addObject(isComplete, completionTime, fetch.m_nBytes);
+    pattern.m_stats.addObject(isComplete, completionTime, fetch.m_nBytes);
+    if (isComplete) {
+      worker.m_lastObjectTime = now;
+    }
+    if (!m_wantQuiet && !worker.m_trace) {
+      auto logLine = (isComplete ? "Object Completed   - PatternType="s : "Object Failed      - PatternType="s) +
+                     std::to_string(fetch.m_patternId + 1) +
+                     ", Name=" + fetch.m_name.toUri() +
+                     ", Segments=" + std::to_string(fetch.m_nReceivedSegments) + "/" + std::to_string(fetch.m_nSegments) +
+                     ", Bytes=" + std::to_string(fetch.m_nBytes) +
+                     ", Time=" + std::to_string(completionTime.count() / 1e6) + "ms";
+      m_logger.log(logLine, true, false);
+    }
+    worker.m_objectFetches.erase(it);
+  }
+
+  bool
+  expressInterest(Worker& worker, std::size_t patternId, const ndn::Interest& interest, uint64_t objectId)
+  {
+    auto& pattern = worker.m_trafficPatterns[patternId];
+    worker.m_stats.m_nInterestsSent++;
+    worker.m_intervalStats.m_nInterestsSent++;
+    pattern.m_stats.m_nInterestsSent++;
+    try {
+      uint64_t seq = worker.m_stats.m_nInterestsSent;
+      uint64_t globalRef = worker.getGlobalId(seq);
+      uint64_t localRef = pattern.m_stats.m_nInterestsSent;
+      auto now = std::chrono::steady_clock::now();
+      // two words of captures fit in the small buffer of std::function, so that the Face
+      // does not make three heap allocations per Interest to store the callbacks
+      worker.m_face->expressInterest(interest,
+        [w = &worker, seq] (auto&&... args) { w->m_client->onData(*w, std::forward<decltype(args)>(args)..., seq); },
+        [w = &worker, seq] (auto&&... args) { w->m_client->onNack(*w, std::forward<decltype(args)>(args)..., seq); },
+        [w = &worker, seq] (auto&&... args) { w->m_client->onTimeout(*w, std::forward<decltype(args)>(args)..., seq); });
+      worker.m_nOutstanding++;
+
+      auto& entry = worker.m_outstanding.insert(seq);
+      entry.m_localRef = localRef;
+      entry.m_patternId = patternId;
+      entry.m_objectId = objectId;
+      auto nonce = interest.getNonce();
+      std::memcpy(&entry.m_nonce, nonce.data(), sizeof(entry.m_nonce));
+      entry.m_sentTime = now;
+      if (m_timeout && !worker.m_isExpiryTimerArmed) {
+        armExpiryTimer(worker, now + *m_timeout);
+      }
+
+      if (worker.m_stats.m_nInterestsSent == 1) {
+        worker.m_firstSendTime = now;
+      }
+      worker.m_lastSendTime = now;
+
+      if (worker.m_trace) {
+        traceEvent(worker, trace::EventType::INTEREST_SENT, seq, entry);
+      }
+      else if (!m_wantQuiet) {
+        auto logLine = "Sending Interest   - PatternType=" + std::to_string(patternId + 1) +
+                       ", GlobalID=" + std::to_string(globalRef) +
+                       ", LocalID=" + std::to_string(localRef) +
+                       ", Name=" + interest.getName().toUri();
+        m_logger.log(logLine, true, false);
+      }
+      return true;
+    }
+    catch (const std::exception& e) {
+      m_logger.log("ERROR: "s + e.what(), true, true);
+      return false;
+    }
+  }
+
+  /**
+   * \brief Sends an Interest, unless the worker has reached its share of `--max-outstanding`, in
+   *        which case the sending opportunity is skipped and counted as held back.
+   *
+   * Held back Interests do not count towards `--count`.
+   */
+  bool
+  trySendInterest(Worker& worker, std::size_t patternId, const ndn::Interest* interest = nullptr)
+  {
+    if (worker.m_nMaximumOutstanding && worker.m_nOutstanding >= *worker.m_nMaximumOutstanding) {
+      worker.m_stats.m_nHeldBack++;
+      worker.m_intervalStats.m_nHeldBack++;
+      worker.m_trafficPatterns[patternId].m_stats.m_nHeldBack++;
+      return true;
+    }
+    if (interest != nullptr) {
+      return expressInterest(worker, patternId, *interest, 0);
+    }
+    return sendInterest(worker, patternId);
+  }
+
+  /**
+   * \brief Starts sending, on the worker's own thread.
+   */
+  void
+  startWorker(Worker& worker)
+  {
+    if (m_replayReader) {
+      startReplay(worker);
+    }
+    else if (m_interestWindow) {
+      fillWindow(worker);
+    }
+    else {
+      startSchedules(worker);
+      scheduleNextWakeup(worker);
+    }
+  }
+
+  void
+  startReplay(Worker& worker)
+  {
+    worker.m_startTime = std::chrono::steady_clock::now();
+    if (!m_replayReader->next(m_replayEvent)) {
+      finishReplay(worker);
+      return;
+    }
+    scheduleReplay(worker);
+  }
+
+  std::chrono::steady_clock::time_point
+  getReplayTime(const Worker& worker, const ReplayEvent& event) const
+  {
+    return worker.m_startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                  std::chrono::duration<double, std::nano>(event.m_time.count() / m_replaySpeed));
+  }
+
+  void
+  scheduleReplay(Worker& worker)
+  {
+    worker.m_timer.expires_at(getReplayTime(worker, m_replayEvent));
+    worker.m_timer.async_wait([this, &worker] (const boost::system::error_code& ec) {
+      if (!ec) {
+        replayInterests(worker);
+      }
+    });
+  }
+
+  /**
+   * \brief Sends the recorded Interests that have become due, as generateTraffic() does.
+   */
+  void
+  replayInterests(Worker& worker)
+  {
+    auto now = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < MAX_BATCH_SIZE; i++) {
+      if (worker.m_nMaximumInterests && worker.m_stats.m_nInterestsSent >= *worker.m_nMaximumInterests) {
+        finishReplay(worker);
+        return;
+      }
+      if (getReplayTime(worker, m_replayEvent) > now) {
+        break;
+      }
+      if (!replayEvent(worker, m_replayEvent)) {
+        return;
+      }
+      if (!m_replayReader->next(m_replayEvent)) {
+        finishReplay(worker);
+        return;
+      }
+    }
+    // the same timer also lets the other handlers run between two batches
+    scheduleReplay(worker);
+  }
+
+  /**
+   * \return false if the worker should stop sending
+   */
+  bool
+  replayEvent(Worker& worker, const ReplayEvent& event)
+  {
+    if (m_replayReader->getFormat() == ReplayReader::Format::TRACE) {
+      auto patternId = event.m_patternId < m_replayPatterns.size() ? m_replayPatterns[event.m_patternId] : std::nullopt;
+      if (!patternId || worker.m_trafficPatterns[*patternId].m_isRemoved) {
+        m_nReplaySkipped++;
+        return true;
+      }
+      return trySendInterest(worker, *patternId);
+    }
+
+    if (event.m_packet.type() != ndn::tlv::Interest) {
+      return true;
+    }
+    ndn::Interest interest;
+    try {
+      interest.wireDecode(event.m_packet);
+    }
+    catch (const std::exception&) {
+      m_nReplaySkipped++;
+      return true;
+    }
+    // the longest prefix among the patterns, for the statistics
+    auto patternId = findPattern(worker, interest.getName(), false);
+    if (!patternId) {
+      m_nReplaySkipped++;
+      return true;
+    }
+    interest.setNonce(getNewNonce(worker.m_nonces));
+    return trySendInterest(worker, *patternId, &interest);
+  }
+
+  /**
+   * \brief Lets the worker finish once its last Interests have been answered.
+   */
+  void
+  finishReplay(Worker& worker)
+  {
+    worker.m_nMaximumInterests = worker.m_stats.m_nInterestsSent;
+    if (worker.isFinished()) {
+      onWorkerFinished();
+    }
+  }
+
+  void
+  startSchedules(Worker& worker)
+  {
+    worker.m_startTime = std::chrono::steady_clock::now();
+    worker.m_nextSendTime = worker.m_startTime +
+                            m_arrivalProcess.getNextArrival(std::chrono::nanoseconds::zero(), m_interestInterval);
+    updatePatternSchedules(worker, worker.m_startTime);
+  }
+
+  /**
+   * \brief (Re)creates the schedules of the patterns that have their own ArrivalProcess.
+   *
+   * A schedule whose interval has not changed keeps its next sending time; a new one
+   * starts at \p now.
+   */
+  void
+  updatePatternSchedules(Worker& worker, std::chrono::steady_clock::time_point now)
+  {
+    std::vector<Worker::PatternSchedule> schedules;
+    for (std::size_t patternId = 0; patternId < worker.m_trafficPatterns.size(); patternId++) {
+      const auto& pattern = worker.m_trafficPatterns[patternId];
+      if (!pattern.m_arrivalProcess || pattern.m_trafficPercentage <= 0.0 || pattern.m_isRemoved) {
+        continue;
+      }
+      auto interval = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        m_interestInterval * (worker.m_totalTrafficPercentage / pattern.m_trafficPercentage));
+      auto it = std::find_if(worker.m_patternSchedules.begin(), worker.m_patternSchedules.end(),
+                             [=] (const auto& schedule) { return schedule.m_patternId == patternId; });
+      if (it != worker.m_patternSchedules.end() && it->m_interval == interval) {
+        schedules.push_back(*it);
+        continue;
+      }
+      auto first = pattern.m_arrivalProcess->getNextArrival(now - worker.m_startTime, interval);
+      schedules.push_back({patternId, interval, worker.m_startTime + first});
+    }
+    worker.m_patternSchedules = std::move(schedules);
+  }
+
+  static std::chrono::steady_clock::time_point
+  getNextWakeup(const Worker& worker)
+  {
+    auto next = worker.m_nextSendTime;
+    for (const auto& schedule : worker.m_patternSchedules) {
+      next = std::min(next, schedule.m_nextSendTime);
+    }
+    return next;
+  }
+
+  void
+  generateTraffic(Worker& worker)
+  {
+    // If the timer fired late, send every Interest that has become due in the meantime,
+    // so that the average rate does not depend on how fast the timer can be re-armed.
+    // The batch size is bounded, to give other handlers a chance to run after a long stall.
+    auto now = std::chrono::steady_clock::now();
+    auto isDone = [&worker] {
+      return worker.m_nMaximumInterests && worker.m_stats.m_nInterestsSent >= *worker.m_nMaximumInterests;
+    };
+
+    for (std::size_t i = 0; i < MAX_BATCH_SIZE && worker.m_nextSendTime <= now; i++) {
+      if (isDone()) {
+        return;
+      }
+
+      auto patternId = selectTrafficPattern(worker);
+      // patterns with their own arrival process are sent on their own schedule
+      if (patternId && !worker.m_trafficPatterns[*patternId].m_arrivalProcess &&
+          !trySendInterest(worker, *patternId)) {
+        return;
+      }
+      worker.m_nextSendTime = worker.m_startTime +
+                              m_arrivalProcess.getNextArrival(worker.m_nextSendTime - worker.m_startTime,
+                                                              m_interestInterval);
+    }
+
+    for (auto& schedule : worker.m_patternSchedules) {
+      const auto& process = *worker.m_trafficPatterns[schedule.m_patternId].m_arrivalProcess;
+      for (std::size_t i = 0; i < MAX_BATCH_SIZE && schedule.m_nextSendTime <= now; i++) {
+        if (isDone() || !trySendInterest(worker, schedule.m_patternId)) {
+          return;
+        }
+        schedule.m_nextSendTime = worker.m_startTime +
+                                  process.getNextArrival(schedule.m_nextSendTime - worker.m_startTime,
+                                                         schedule.m_interval);
+      }
+    }
+
+    scheduleNextWakeup(worker);
+  }
+
+  void
+  scheduleNextWakeup(Worker& worker)
+  {
+    worker.m_timer.expires_at(getNextWakeup(worker));
+    worker.m_timer.async_wait([this, &worker] (const boost::system::error_code& ec) {
+      if (!ec) {
+        generateTraffic(worker);
+      }
+    });
+  }
+
+  /**
+   * \brief Sends Interests until the window is full (window mode only).
+   */
+  void
+  fillWindow(Worker& worker)
+  {
+    while (worker.m_nOutstanding < static_cast<uint64_t>(worker.m_window)) {
+      if (worker.m_nMaximumInterests && worker.m_stats.m_nInterestsSent >= *worker.m_nMaximumInterests) {
+        return;
+      }
+      auto patternId = selectTrafficPattern(worker);
+      if (!patternId || !sendInterest(worker, *patternId)) {
+        return;
+      }
+    }
+  }
+
+  /**
+   * \brief Called by each worker when the last of its Interests has been answered or has expired.
+   */
+  void
+  onWorkerFinished()
+  {
+    boost::asio::post(m_io, [this] {
+      if (++m_nWorkersFinished == m_workers.size()) {
+        stop();
+      }
+    });
+  }
+
+  void
+  scheduleReport()
+  {
+    m_reportTimer.expires_after(*m_reportInterval);
+    m_reportTimer.async_wait([this] (const boost::system::error_code& ec) {
+      if (!ec) {
+        collectReport();
+        scheduleReport();
+      }
+    });
+  }
+
+  /**
+   * \brief Takes each worker's interval statistics, on its own thread, and reports their sum.
+   */
+  void
+  collectReport()
+  {
+    auto total = std::make_shared<TrafficStatistics>();
+    auto nPending = std::make_shared<std::size_t>(m_workers.size());
+    for (auto& worker : m_workers) {
+      boost::asio::post(worker->m_io, [this, total, nPending, &worker = *worker] {
+        auto snapshot = std::make_shared<TrafficStatistics>(std::exchange(worker.m_intervalStats, {}));
+        boost::asio::post(m_io, [this, total, nPending, snapshot] {
+          total->merge(*snapshot);
+          if (--*nPending == 0) {
+            logIntervalReport(*total);
+          }
+        });
+      });
+    }
+  }
+
+  void
+  logIntervalReport(const TrafficStatistics& stats)
+  {
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - m_lastReportTime).count();
+    m_lastReportTime = now;
+    if (!(elapsed > 0.0)) {
+      return;
+    }
+
+    // loss is relative to the Interests that were completed in this interval
+    auto nCompleted = stats.m_nInterestsReceived + stats.m_nNacks + stats.m_nTimeouts;
+    double loss = nCompleted > 0 ? (nCompleted - stats.m_nInterestsReceived) * 100.0 / nCompleted : 0.0;
+    const auto& rtt = stats.m_roundTripTimes;
+
+    m_intervalReporter.report(m_logger, {
+      {"Time", std::chrono::duration<double>(now - m_reportStartTime).count()},
+      {"InterestsPerSecond", stats.m_nInterestsSent / elapsed},
+      {"HeldBackPerSecond", stats.m_nHeldBack / elapsed},
+      {"DataPerSecond", stats.m_nInterestsReceived / elapsed},
+      {"NacksPerSecond", stats.m_nNacks / elapsed},
+      {"TimeoutsPerSecond", stats.m_nTimeouts / elapsed},
+      {"LossPercent", loss},
+      {"RttP50Ms", rtt.getPercentile(50.0) / 1e6},
+      {"RttP90Ms", rtt.getPercentile(90.0) / 1e6},
+      {"RttP99Ms", rtt.getPercentile(99.0) / 1e6},
+      {"RttP999Ms", rtt.getPercentile(99.9) / 1e6},
+      {"RttMaxMs", rtt.getMax() / 1e6},
+      {"ResidentMemoryMiB", getResidentMemory() / 1048576.0},
+    });
+  }
+
+  /**
+   * \brief Cumulative counters of one traffic pattern, as exported to the metrics endpoint.
+   */
+  class PatternCounters
+  {
+  public:
+    /**
+     * \param stats a TrafficStatistics or another PatternCounters
+     */
+    template<typename Counters>
+    void
+    add(const Counters& stats)
+    {
+      m_nInterestsSent += stats.m_nInterestsSent;
+      m_nInterestsReceived += stats.m_nInterestsReceived;
+      m_nNacks += stats.m_nNacks;
+      m_nTimeouts += stats.m_nTimeouts;
+      m_nLateData += stats.m_nLateData;
+      m_nContentInconsistencies += stats.m_nContentInconsistencies;
+      m_nSignatureFailures += stats.m_nSignatureFailures;
+    }
+
+  public:
+    uint64_t m_nInterestsSent = 0;
+    uint64_t m_nInterestsReceived = 0;
+    uint64_t m_nNacks = 0;
+    uint64_t m_nTimeouts = 0;
+    uint64_t m_nLateData = 0;
+    uint64_t m_nContentInconsistencies = 0;
+    uint64_t m_nSignatureFailures = 0;
+  };
+
+  /**
+   * \brief Reads the counters of each worker on its own thread, and replies with their sum.
+   */
+  void
+  collectMetrics(MetricsServer::Reply reply)
+  {
+    auto total = std::make_shared<std::vector<PatternCounters>>(m_trafficPatterns.size());
+    auto nOutstanding = std::make_shared<uint64_t>(0);
+    auto nPending = std::make_shared<std::size_t>(m_workers.size());
+    for (auto& worker : m_workers) {
+      boost::asio::post(worker->m_io, [=, &worker = *worker] {
+        std::vector<PatternCounters> snapshot(worker.m_trafficPatterns.size());
+        for (std::size_t patternId = 0; patternId < snapshot.size(); patternId++) {
+          snapshot[patternId].add(worker.m_trafficPatterns[patternId].m_stats);
+        }
+        boost::asio::post(m_io, [=, snapshot = std::move(snapshot), n = worker.m_nOutstanding] {
+          // the worker may not have applied the latest reload yet
+          for (std::size_t patternId = 0; patternId < std::min(snapshot.size(), total->size()); patternId++) {
+            (*total)[patternId].add(snapshot[patternId]);
+          }
+          *nOutstanding += n;
+          if (--*nPending == 0) {
+            reply(formatMetrics(*total, *nOutstanding));
+          }
+        });
+      });
+    }
+  }
+
+  std::string
+  formatMetrics(const std::vector<PatternCounters>& counters, uint64_t nOutstanding) const
+  {
+    std::ostringstream os;
+    auto addCounter = [&] (const char* name, const char* help, uint64_t PatternCounters::* member) {
+      os << "# HELP " << name << ' ' << help << "\n"
+         << "# TYPE " << name << " counter\n";
+      for (std::size_t patternId = 0; patternId < counters.size(); patternId++) {
+        os << name << "{pattern=\"" << patternId + 1 << "\",name=\""
+           << MetricsServer::escapeLabelValue(m_trafficPatterns[patternId].m_name) << "\"} "
+           << counters[patternId].*member << "\n";
+      }
+    };
+
+    addCounter("ndntg_client_interests_sent_total", "Interests sent", &PatternCounters::m_nInterestsSent);
+    addCounter("ndntg_client_data_received_total", "Data packets received", &PatternCounters::m_nInterestsReceived);
+    addCounter("ndntg_client_nacks_received_total", "Nacks received", &PatternCounters::m_nNacks);
+    addCounter("ndntg_client_timeouts_total", "Interests that timed out", &PatternCounters::m_nTimeouts);
+    addCounter("ndntg_client_late_data_received_total", "Data packets received after the timeout",
+               &PatternCounters::m_nLateData);
+    addCounter("ndntg_client_content_inconsistencies_total", "Data packets with unexpected content",
+               &PatternCounters::m_nContentInconsistencies);
+    addCounter("ndntg_client_signature_failures_total", "Data packets whose signature did not verify",
+               &PatternCounters::m_nSignatureFailures);
+    os << "# HELP ndntg_client_interests_outstanding Interests waiting for Data, Nack, or timeout\n"
+       << "# TYPE ndntg_client_interests_outstanding gauge\n"
+       << "ndntg_client_interests_outstanding " << nOutstanding << "\n";
+    return os.str();
+  }
+
+  /**
+   * \brief Binds the calling thread, which runs \p worker, to its CPU of --cpu-affinity, and
+   *        reallocates the preallocated state of the worker on the NUMA node of that CPU.
+   * \throw std::runtime_error
+   */
+  void
+  placeWorker(Worker& worker)
+  {
+    auto placement = m_eventLoopOptions.placeWorker(worker.m_id);
+    if (!placement) {
+      return;
+    }
+    // the table is still empty: only the first Interests have been posted so far
+    BOOST_ASSERT(worker.m_outstanding.size() == 0);
+    worker.m_outstanding = OutstandingTable(worker.m_outstanding.getCapacity());
+    m_logger.log("Worker #" + std::to_string(worker.m_id + 1) + " runs on " + *placement, true, false);
+  }
+
+  void
+  shutdownWorkers()
+  {
+    for (auto& worker : m_workers) {
+      boost::asio::post(worker->m_io, [&worker = *worker] {
+        worker.m_timer.cancel();
+        worker.m_expiryTimer.cancel();
+        worker.m_face->shutdown();
+        worker.m_io.stop();
+      });
+    }
+  }
+
+  void
+  stop()
+  {
+    m_signalSet.cancel();
+    m_reloadSignalSet.cancel();
+    m_startTimer.cancel();
+    m_reportTimer.cancel();
+    m_memoryWatchdog.cancel();
+    if (m_metricsServer) {
+      m_metricsServer->close();
+    }
+    shutdownWorkers();
+  }
+
+private:
+  static constexpr std::size_t MAX_BATCH_SIZE = 4096;
+  /// how far ahead of this clock the start time of the controller can be, beyond which the
+  /// clocks are considered unsynchronized
+  static constexpr std::chrono::seconds MAX_START_DELAY{60};
+
+  Logger m_logger{"NdnTrafficClient"};
+  boost::asio::io_context m_io;
+  boost::asio::signal_set m_signalSet{m_io, SIGINT, SIGTERM};
+  boost::asio::signal_set m_reloadSignalSet{m_io, SIGHUP};
+  boost::asio::steady_timer m_startTimer{m_io};
+  boost::asio::steady_timer m_reportTimer{m_io};
+  MemoryWatchdog m_memoryWatchdog{m_io};
+
+  std::string m_configurationFile;
+  std::string m_timestampFormat;
+  std::optional<uint64_t> m_nMaximumInterests;
+  std::chrono::nanoseconds m_interestInterval = std::chrono::seconds(1);
+  ArrivalProcess m_arrivalProcess;
+  std::optional<std::size_t> m_interestWindow;
+  bool m_isWindowAdaptive = false;
+  std::optional<std::size_t> m_nMaximumOutstanding;
+  std::size_t m_nonceWindow = 1000;
+  std::size_t m_nThreads = 1;
+  std::optional<std::chrono::nanoseconds> m_timeout;
+  std::string m_traceFile;
+  std::optional<std::chrono::nanoseconds> m_reportInterval;
+  IntervalReporter m_intervalReporter;
+  std::chrono::steady_clock::time_point m_reportStartTime;
+  std::chrono::steady_clock::time_point m_lastReportTime;
+  std::optional<boost::asio::ip::tcp::endpoint> m_metricsEndpoint;
+  TransportOptions m_transportOptions;
+  FaceFactory m_faceFactory;
+  EventLoopOptions m_eventLoopOptions;
+
+  // replay only, on the thread of the only worker
+  std::string m_replayFile;
+  double m_replaySpeed = 1.0;
+  std::unique_ptr<ReplayReader> m_replayReader;
+  std::vector<std::optional<std::size_t>> m_replayPatterns; ///< by pattern ID in a binary trace
+  ReplayEvent m_replayEvent; ///< the next one to send
+  uint64_t m_nReplaySkipped = 0; ///< no matching traffic pattern
+
+  // controller only
+  std::optional<boost::asio::ip::tcp::endpoint> m_agentsEndpoint;
+  std::size_t m_nAgents = 0;
+  double m_agentAchievedRate = 0.0;
+  double m_agentGoodput = 0.0;
+
+  // agent only
+  std::optional<boost::asio::ip::tcp::endpoint> m_controllerEndpoint;
+  std::unique_ptr<coordination::Connection> m_controller;
+  std::optional<std::string> m_configurationText; ///< sent by the controller
+  std::optional<coordination::Controller::Clock::time_point> m_startTime;
+  std::unique_ptr<MetricsServer> m_metricsServer;
+
+  std::vector<InterestTrafficConfiguration> m_trafficPatterns;
+  double m_totalTrafficPercentage = 0.0;
+  AliasTable m_patternSelector;
+  std::unique_ptr<trace::TraceWriter> m_traceWriter; // must outlive the workers' buffers
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  std::size_t m_nWorkersFinished = 0;
+  TrafficStatistics m_stats;
+
+  bool m_wantQuiet = false;
+  bool m_wantAsyncLogging = false;
+  bool m_wantVerbose = false;
+  bool m_wantBrief = false;
+  std::atomic<bool> m_hasError{false};
+};
+
+} // namespace ndntg
+
+#endif // NDNTG_NDN_TRAFFIC_CLIENT_HPP
@@ -18,346 +18,14 @@
  * Author: Jerald Paul Abraham <jeraldabraham@email.arizona.edu>
  */
 
-#include "util.hpp"
+#include "ndn-traffic-server.hpp"
 
-#include <ndn-cxx/data.hpp>
-#include <ndn-cxx/face.hpp>
-#include <ndn-cxx/interest.hpp>
-#include <ndn-cxx/security/key-chain.hpp>
-#include <ndn-cxx/security/signing-info.hpp>
-#include <ndn-cxx/util/random.hpp>
-#include <ndn-cxx/util/time.hpp>
-
-#include <chrono>
-#include <limits>
-#include <optional>
-#include <sstream>
-#include <thread>
-#include <vector>
-
-#include <boost/asio/io_context.hpp>
-#include <boost/asio/signal_set.hpp>
-#include <boost/core/noncopyable.hpp>
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/parsers.hpp>
 #include <boost/program_options/variables_map.hpp>
 
 using namespace std::chrono_literals;
 
-namespace ndntg {
-
-using namespace ndn::time_literals;
-using namespace std::string_literals;
-
-class NdnTrafficServer : boost::noncopyable
-{
-public:
-  explicit
-  NdnTrafficServer(std::string configFile)
-    : m_configurationFile(std::move(configFile))
-  {
-  }
-
-  void
-  setMaximumInterests(uint64_t maxInterests)
-  {
-    m_nMaximumInterests = maxInterests;
-  }
-
-  void
-  setContentDelay(std::chrono::milliseconds delay)
-  {
-    BOOST_ASSERT(delay >= 0ms);
-    m_contentDelay = delay;
-  }
-
-  void
-  setTimestampFormat(std::string format)
-  {
-    m_timestampFormat = std::move(format);
-  }
-
-  void
-  setQuietLogging()
-  {
-    m_wantQuiet = true;
-  }
-
-  int
-  run()
-  {
-    m_logger.initialize(std::to_string(ndn::random::generateWord32()), m_timestampFormat);
-
-    if (!readConfigurationFile(m_configurationFile, m_trafficPatterns, m_logger)) {
-      return 2;
-    }
-
-    if (!checkTrafficPatternCorrectness()) {
-      m_logger.log("ERROR: Traffic configuration provided is not proper", false, true);
-      return 2;
-    }
-
-    m_logger.log("Traffic configuration file processing completed\n", true, false);
-    for (std::size_t i = 0; i < m_trafficPatterns.size(); i++) {
-      m_logger.log("Traffic Pattern Type #" + std::to_string(i + 1), false, false);
-      m_trafficPatterns[i].printTrafficConfiguration(m_logger);
-      m_logger.log("", false, false);
-    }
-
-    if (m_nMaximumInterests == 0) {
-      logStatistics();
-      return 0;
-    }
-
-    m_signalSet.async_wait([this] (const boost::system::error_code&, int) {
-      if (m_nMaximumInterests && m_nInterestsReceived < *m_nMaximumInterests) {
-        m_hasError = true;
-      }
-      stop();
-    });
-
-    for (std::size_t id = 0; id < m_trafficPatterns.size(); id++) {
-      m_registeredPrefixes.push_back(
-        m_face.setInterestFilter(m_trafficPatterns[id].m_name,
-                                 [this, id] (auto&&, const auto& interest) { onInterest(interest, id); },
-                                 nullptr,
-                                 [this, id] (auto&&, const auto& reason) { onRegisterFailed(reason, id); }));
-    }
-
-    try {
-      m_face.processEvents();
-      return m_hasError ? 1 : 0;
-    }
-    catch (const std::exception& e) {
-      m_logger.log("ERROR: "s + e.what(), true, true);
-      m_io.stop();
-      return 1;
-    }
-  }
-
-private:
-  class DataTrafficConfiguration
-  {
-  public:
-    void
-    printTrafficConfiguration(Logger& logger) const
-    {
-      std::ostringstream os;
-
-      if (!m_name.empty()) {
-        os << "Name=" << m_name << ", ";
-      }
-      if (m_contentDelay >= 0ms) {
-        os << "ContentDelay=" << m_contentDelay.count() << ", ";
-      }
-      if (m_freshnessPeriod >= 0_ms) {
-        os << "FreshnessPeriod=" << m_freshnessPeriod.count() << ", ";
-      }
-      if (m_contentType) {
-        os << "ContentType=" << *m_contentType << ", ";
-      }
-      if (m_contentLength) {
-        os << "ContentBytes=" << *m_contentLength << ", ";
-      }
-      if (!m_content.empty()) {
-        os << "Content=" << m_content << ", ";
-      }
-      os << "SigningInfo=" << m_signingInfo;
-
-      logger.log(os.str(), false, false);
-    }
-
-    bool
-    parseConfigurationLine(const std::string& line, Logger& logger, int lineNumber)
-    {
-      std::string parameter, value;
-      if (!extractParameterAndValue(line, parameter, value)) {
-        logger.log("Line " + std::to_string(lineNumber) + " - Invalid syntax: " + line,
-                   false, true);
-        return false;
-      }
-
-      if (parameter == "Name") {
-        m_name = value;
-      }
-      else if (parameter == "ContentDelay") {
-        m_contentDelay = std::chrono::milliseconds(std::stoul(value));
-      }
-      else if (parameter == "FreshnessPeriod") {
-        m_freshnessPeriod = ndn::time::milliseconds(std::stoul(value));
-      }
-      else if (parameter == "ContentType") {
-        m_contentType = std::stoul(value);
-      }
-      else if (parameter == "ContentBytes") {
-        m_contentLength = std::stoul(value);
-      }
-      else if (parameter == "Content") {
-        m_content = value;
-      }
-      else if (parameter == "SigningInfo") {
-        m_signingInfo = ndn::security::SigningInfo(value);
-      }
-      else {
-        logger.log("Line " + std::to_string(lineNumber) + " - Ignoring unknown parameter: " + parameter,
-                   false, true);
-      }
-      return true;
-    }
-
-    bool
-    checkTrafficDetailCorrectness() const
-    {
-      return true;
-    }
-
-  public:
-    std::string m_name;
-    std::chrono::milliseconds m_contentDelay{-1};
-    ndn::time::milliseconds m_freshnessPeriod{-1};
-    std::optional<uint32_t> m_contentType;
-    std::optional<std::size_t> m_contentLength;
-    std::string m_content;
-    ndn::security::SigningInfo m_signingInfo;
-    uint64_t m_nInterestsReceived = 0;
-  };
-
-  void
-  logStatistics()
-  {
-    using std::to_string;
-
-    m_logger.log("\n\n== Traffic Report ==\n", false, true);
-    m_logger.log("Total Traffic Pattern Types = " + to_string(m_trafficPatterns.size()), false, true);
-    m_logger.log("Total Interests Received    = " + to_string(m_nInterestsReceived) + "\n", false, true);
-
-    for (std::size_t patternId = 0; patternId < m_trafficPatterns.size(); patternId++) {
-      const auto& pattern = m_trafficPatterns[patternId];
-
-      m_logger.log("Traffic Pattern Type #" + to_string(patternId + 1), false, true);
-      pattern.printTrafficConfiguration(m_logger);
-      m_logger.log("Total Interests Received    = " +
-                   to_string(pattern.m_nInterestsReceived) + "\n", false, true);
-    }
-  }
-
-  bool
-  checkTrafficPatternCorrectness() const
-  {
-    // TODO
-    return true;
-  }
-
-  static std::string
-  getRandomByteString(std::size_t length)
-  {
-    // per ISO C++ std, cannot instantiate uniform_int_distribution with char
-    static std::uniform_int_distribution<short> dist(std::numeric_limits<char>::min(),
-                                                     std::numeric_limits<char>::max());
-
-    std::string s;
-    s.reserve(length);
-    for (std::size_t i = 0; i < length; i++) {
-      s += static_cast<char>(dist(ndn::random::getRandomNumberEngine()));
-    }
-    return s;
-  }
-
-  void
-  onInterest(const ndn::Interest& interest, std::size_t patternId)
-  {
-    auto& pattern = m_trafficPatterns[patternId];
-
-    if (!m_nMaximumInterests || m_nInterestsReceived < *m_nMaximumInterests) {
-      ndn::Data data(interest.getName());
-
-      if (pattern.m_freshnessPeriod >= 0_ms)
-        data.setFreshnessPeriod(pattern.m_freshnessPeriod);
-
-      if (pattern.m_contentType)
-        data.setContentType(*pattern.m_contentType);
-
-      std::string content;
-      if (pattern.m_contentLength > 0)
-        content = getRandomByteString(*pattern.m_contentLength);
-      if (!pattern.m_content.empty())
-        content = pattern.m_content;
-      data.setContent(ndn::makeStringBlock(ndn::tlv::Content, content));
-
-      m_keyChain.sign(data, pattern.m_signingInfo);
-
-      m_nInterestsReceived++;
-      pattern.m_nInterestsReceived++;
-
-      if (!m_wantQuiet) {
-        auto logLine = "Interest Received          - PatternType=" + std::to_string(patternId + 1) +
-                       ", GlobalID=" + std::to_string(m_nInterestsReceived) +
-                       ", LocalID=" + std::to_string(pattern.m_nInterestsReceived) +
-                       ", Name=" + interest.getName().toUri();
-        m_logger.log(logLine, true, false);
-      }
-
-      if (pattern.m_contentDelay > 0ms)
-        std::this_thread::sleep_for(pattern.m_contentDelay);
-      if (m_contentDelay > 0ms)
-        std::this_thread::sleep_for(m_contentDelay);
-
-      m_face.put(data);
-    }
-
-    if (m_nMaximumInterests && m_nInterestsReceived >= *m_nMaximumInterests) {
-      logStatistics();
-      m_registeredPrefixes.clear();
-      m_signalSet.cancel();
-    }
-  }
-
-  void
-  onRegisterFailed(const std::string& reason, std::size_t patternId)
-  {
-    auto logLine = "Prefix registration failed - PatternType=" + std::to_string(patternId + 1) +
-                   ", Name=" + m_trafficPatterns[patternId].m_name +
-                   ", Reason=" + reason;
-    m_logger.log(logLine, true, true);
-
-    m_nRegistrationsFailed++;
-    if (m_nRegistrationsFailed == m_trafficPatterns.size()) {
-      m_hasError = true;
-      stop();
-    }
-  }
-
-  void
-  stop()
-  {
-    logStatistics();
-    m_face.shutdown();
-    m_io.stop();
-  }
-
-private:
-  Logger m_logger{"NdnTrafficServer"};
-  boost::asio::io_context m_io;
-  boost::asio::signal_set m_signalSet{m_io, SIGINT, SIGTERM};
-  ndn::Face m_face{m_io};
-  ndn::KeyChain m_keyChain;
-
-  std::string m_configurationFile;
-  std::string m_timestampFormat;
-  std::optional<uint64_t> m_nMaximumInterests;
-  std::chrono::milliseconds m_contentDelay{0};
-
-  std::vector<DataTrafficConfiguration> m_trafficPatterns;
-  std::vector<ndn::ScopedRegisteredPrefixHandle> m_registeredPrefixes;
-  uint64_t m_nRegistrationsFailed = 0;
-  uint64_t m_nInterestsReceived = 0;
-
-  bool m_wantQuiet = false;
-  bool m_hasError = false;
-};
-
-} // namespace ndntg
-
 namespace po = boost::program_options;
 
 static void
@@ -367,6 +35,7 @@ usage(std::ostream& os, std::string_view programName, const po::options_descript
      << "\n"
      << "Respond to Interests as per provided Traffic_Configuration_File.\n"
      << "Multiple prefixes can be configured for handling.\n"
+     << "Send SIGHUP to re-read Traffic_Configuration_File without interrupting the service.\n"
      << "Set the environment variable NDN_TRAFFIC_LOGFOLDER to redirect output to a log file.\n"
      << "\n"
      << desc;
@@ -386,6 +55,26 @@ main(int argc, char* argv[])
                   "wait this amount of milliseconds before responding to each Interest")
     ("timestamp-format,t", po::value<std::string>(&timestampFormat), "format string for timestamp output")
     ("quiet,q",   po::bool_switch(), "turn off logging of Interest reception and Data generation")
+    ("async-logging", po::bool_switch(), "log from a background thread, dropping per-packet lines when it falls behind")
+    ("brief",     po::bool_switch(), "do not print the configuration and statistics of each traffic pattern")
+    ("threads,T", po::value<std::size_t>()->default_value(1),
+                  "number of worker threads; traffic patterns are distributed among them")
+    ("report-interval", po::value<double>(), "print the statistics of the last interval every this many seconds")
+    ("report-format", po::value<std::string>()->default_value("text"),
+                  "format of the interval reports: text, json, or csv")
+    ("metrics-listen", po::value<std::string>(),
+                  "serve Prometheus metrics over HTTP at this HOST:PORT (the path is /metrics)")
+    ;
+  ndntg::MemoryWatchdog::addCommandLineOptions(visibleOptions);
+  ndntg::TransportOptions::addCommandLineOptions(visibleOptions);
+  ndntg::EventLoopOptions::addCommandLineOptions(visibleOptions);
+  visibleOptions.add_options()
+    ("size-map", po::value<std::string>(),
+                  "give the Data of every name listed in this file, one 'NAME LENGTH' per line, the "
+                  "listed content length, e.g. to serve the Interests replayed from a capture")
+    ("bench-signing", po::value<int64_t>(),
+                  "do not serve; sign this many Data packets of every traffic pattern and report "
+                  "the cost, on 1 and on --threads threads")
     ;
 
   po::options_description hiddenOptions;
@@ -443,13 +132,82 @@ main(int argc, char* argv[])
     server.setContentDelay(delay);
   }
 
+  if (vm.count("threads") > 0) {
+    auto nThreads = vm["threads"].as<std::size_t>();
+    if (nThreads == 0) {
+      std::cerr << "ERROR: the argument for option '--threads' must be positive\n";
+      return 2;
+    }
+    server.setThreads(nThreads);
+  }
+
+  if (vm.count("bench-signing") > 0) {
+    auto nPackets = vm["bench-signing"].as<int64_t>();
+    if (nPackets <= 0) {
+      std::cerr << "ERROR: the argument for option '--bench-signing' must be positive\n";
+      return 2;
+    }
+    server.setSigningBenchmark(static_cast<uint64_t>(nPackets));
+  }
+
+  if (vm.count("size-map") > 0) {
+    server.setContentSizeMap(vm["size-map"].as<std::string>());
+  }
+
+  try {
+    server.setEventLoopOptions(ndntg::EventLoopOptions::fromCommandLine(vm));
+    server.setTransportOptions(ndntg::TransportOptions::fromCommandLine(vm));
+    if (auto limit = ndntg::MemoryWatchdog::fromCommandLine(vm); limit) {
+      server.setMemoryLimit(*limit);
+    }
+  }
+  catch (const std::invalid_argument& e) {
+    std::cerr << "ERROR: " << e.what() << "\n";
+    return 2;
+  }
+
+  if (vm.count("report-interval") > 0) {
+    auto interval = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::duration<double>(vm["report-interval"].as<double>()));
+    if (interval <= std::chrono::nanoseconds::zero()) {
+      std::cerr << "ERROR: the argument for option '--report-interval' must be positive\n";
+      return 2;
+    }
+    try {
+      server.setReportInterval(interval,
+                               ndntg::IntervalReporter::parseFormat(vm["report-format"].as<std::string>()));
+    }
+    catch (const std::exception&) {
+      std::cerr << "ERROR: invalid argument for option '--report-format'\n";
+      return 2;
+    }
+  }
+
+  if (vm.count("metrics-listen") > 0) {
+    try {
+      server.setMetricsEndpoint(ndntg::MetricsServer::parseEndpoint(vm["metrics-listen"].as<std::string>()));
+    }
+    catch (const std::exception&) {
+      std::cerr << "ERROR: invalid argument for option '--metrics-listen'\n";
+      return 2;
+    }
+  }
+
   if (!timestampFormat.empty()) {
     server.setTimestampFormat(std::move(timestampFormat));
   }
 
+  if (vm["async-logging"].as<bool>()) {
+    server.setAsyncLogging();
+  }
+
   if (vm["quiet"].as<bool>()) {
     server.setQuietLogging();
   }
 
+  if (vm["brief"].as<bool>()) {
+    server.setBriefLogging();
+  }
+
   return server.run();
 }
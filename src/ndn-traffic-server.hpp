@@ -0,0 +1,1752 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2023, Arizona Board of Regents.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Jerald Paul Abraham <jeraldabraham@email.arizona.edu>
+ */
+
+#ifndef NDNTG_NDN_TRAFFIC_SERVER_HPP
+#define NDNTG_NDN_TRAFFIC_SERVER_HPP
+
+#include "allocation-counter.hpp"
+#include "batching-transport.hpp"
+#include "event-loop.hpp"
+#include "interval-report.hpp"
+#include "memory-usage.hpp"
+#include "metrics-server.hpp"
+#include "profiler.hpp"
+#include "util.hpp"
+
+#include <ndn-cxx/data.hpp>
+#include <ndn-cxx/face.hpp>
+#include <ndn-cxx/interest.hpp>
+#include <ndn-cxx/security/key-chain.hpp>
+#include <ndn-cxx/security/signing-info.hpp>
+#include <ndn-cxx/util/random.hpp>
+#include <ndn-cxx/util/time.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/signal_set.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/core/noncopyable.hpp>
+#include <boost/lexical_cast.hpp>
+
+namespace ndntg {
+
+using namespace ndn::time_literals;
+using namespace std::chrono_literals;
+using namespace std::string_literals;
+
+class NdnTrafficServer : boost::noncopyable
+{
+public:
+  using FaceFactory = std::function<std::unique_ptr<ndn::Face>(boost::asio::io_context& io)>;
+
+  explicit
+  NdnTrafficServer(std::string configFile)
+    : m_configurationFile(std::move(configFile))
+  {
+  }
+
+  void
+  setMaximumInterests(uint64_t maxInterests)
+  {
+    m_nMaximumInterests = maxInterests;
+  }
+
+  void
+  setContentDelay(std::chrono::milliseconds delay)
+  {
+    BOOST_ASSERT(delay >= 0ms);
+    m_contentDelay = delay;
+  }
+
+  void
+  setTimestampFormat(std::string format)
+  {
+    m_timestampFormat = std::move(format);
+  }
+
+  void
+  setQuietLogging()
+  {
+    m_wantQuiet = true;
+  }
+
+  void
+  setAsyncLogging()
+  {
+    m_wantAsyncLogging = true;
+  }
+
+  /**
+   * \brief Omits the configuration and statistics of every single traffic pattern.
+   */
+  void
+  setBriefLogging()
+  {
+    m_wantBrief = true;
+  }
+
+  void
+  setThreads(std::size_t nThreads)
+  {
+    BOOST_ASSERT(nThreads > 0);
+    m_nThreads = nThreads;
+  }
+
+  /**
+   * \brief Instead of serving, signs \p nPackets Data packets of every traffic pattern and reports
+   *        the cost, on one thread and, if more were requested with setThreads(), on all of them.
+   */
+  void
+  setSigningBenchmark(uint64_t nPackets)
+  {
+    BOOST_ASSERT(nPackets > 0);
+    m_nBenchmarkPackets = nPackets;
+  }
+
+  /**
+   * \brief Serves the traffic counters in the Prometheus format at http://\p endpoint/metrics.
+   */
+  void
+  setMetricsEndpoint(const boost::asio::ip::tcp::endpoint& endpoint)
+  {
+    m_metricsEndpoint = endpoint;
+  }
+
+  /**
+   * \brief Prints the statistics of the last \p interval every \p interval while running.
+   */
+  void
+  setReportInterval(std::chrono::nanoseconds interval, IntervalReporter::Format format)
+  {
+    BOOST_ASSERT(interval > std::chrono::nanoseconds::zero());
+    m_reportInterval = interval;
+    m_intervalReporter = IntervalReporter(format);
+  }
+
+  /**
+   * \brief Stops with an error once the resident memory of the process exceeds \p limit bytes.
+   */
+  void
+  setMemoryLimit(uint64_t limit)
+  {
+    BOOST_ASSERT(limit > 0);
+    m_memoryWatchdog.setLimit(limit);
+  }
+
+  /**
+   * \brief Chooses the transport and the write batching of the Face of every worker.
+   */
+  void
+  setTransportOptions(TransportOptions options)
+  {
+    m_transportOptions = std::move(options);
+  }
+
+  /**
+   * \brief Chooses the CPUs of the workers and how they wait for packets.
+   */
+  void
+  setEventLoopOptions(EventLoopOptions options)
+  {
+    m_eventLoopOptions = std::move(options);
+  }
+
+  /**
+   * \brief Makes the content of the Data for every name listed in \p filename as long as
+   *        listed there, whatever the traffic pattern.
+   *
+   * Each line of the file is a name URI and a content length in bytes, separated by spaces;
+   * empty lines and lines that start with '#' are ignored.
+   */
+  void
+  setContentSizeMap(std::string filename)
+  {
+    m_contentSizeFile = std::move(filename);
+  }
+
+  /**
+   * \brief Creates the Face of every worker, instead of connecting to the local forwarder.
+   *
+   * This is meant for ndn-traffic-benchmark, which replaces the forwarder with in-process faces.
+   */
+  void
+  setFaceFactory(FaceFactory factory)
+  {
+    m_faceFactory = std::move(factory);
+  }
+
+  int
+  run()
+  {
+    m_logger.initialize(std::to_string(ndn::random::generateWord32()), m_timestampFormat);
+    if (m_wantAsyncLogging) {
+      m_logger.startAsync();
+    }
+
+    if (!readConfigurationFile(m_configurationFile, m_trafficPatterns, m_logger)) {
+      return 2;
+    }
+
+    if (!checkTrafficPatternCorrectness(m_trafficPatterns)) {
+      m_logger.log("ERROR: Traffic configuration provided is not proper", false, true);
+      return 2;
+    }
+
+    m_logger.log("Traffic configuration file processing completed\n", true, false);
+    for (std::size_t i = 0; i < m_trafficPatterns.size() && !m_wantBrief; i++) {
+      m_logger.log("Traffic Pattern Type #" + std::to_string(i + 1), false, false);
+      m_trafficPatterns[i].printTrafficConfiguration(m_logger);
+      m_logger.log("", false, false);
+    }
+
+    if (!m_contentSizeFile.empty() && !readContentSizeMap()) {
+      return 2;
+    }
+    m_contentPool = makeContentPool(m_trafficPatterns, m_maxMappedContentLength);
+
+    if (m_nBenchmarkPackets) {
+      return runSigningBenchmark();
+    }
+
+    if (m_nMaximumInterests == 0) {
+      logStatistics();
+      return 0;
+    }
+
+    if (m_metricsEndpoint) {
+      try {
+        m_metricsServer = std::make_unique<MetricsServer>(m_io, *m_metricsEndpoint,
+                                                          [this] (auto reply) { collectMetrics(std::move(reply)); });
+      }
+      catch (const std::exception& e) {
+        m_logger.log("ERROR: cannot listen for metrics requests: "s + e.what(), false, true);
+        return 2;
+      }
+    }
+
+    auto faceFactory = m_faceFactory;
+    if (!faceFactory) {
+      try {
+        faceFactory = m_transportOptions.makeFaceFactory(m_eventLoopOptions.m_socketBusyPoll, true, &m_isDatagramTransport);
+      }
+      catch (const std::exception& e) {
+        m_logger.log("ERROR: "s + e.what(), false, true);
+        return 2;
+      }
+      if (m_isDatagramTransport) {
+        m_logger.log("Prefixes are not registered over UDP: " +
+                     m_transportOptions.m_uri.value_or(BatchingTransport::getDefaultUri()) +
+                     " needs a route towards the same port of this host for each of them", false, true);
+      }
+    }
+
+    // each traffic pattern is served by exactly one worker, so there is no point in
+    // starting more workers than there are patterns
+    auto nWorkers = std::max<std::size_t>(1, std::min(m_nThreads, m_trafficPatterns.size()));
+    if (m_isDatagramTransport) {
+      // the forwarder sends all Interests to one UDP port, which only one worker can own
+      nWorkers = 1;
+    }
+    if (nWorkers < m_nThreads) {
+      m_logger.log("Using " + std::to_string(nWorkers) + " worker threads (" +
+                   (m_isDatagramTransport ? "UDP transport" : "one per traffic pattern") + ")",
+                   false, true);
+    }
+    // the first worker runs on the main thread and shares its io_context with the signal set
+    m_workers.push_back(std::make_unique<Worker>(0, faceFactory, &m_io));
+    for (std::size_t i = 1; i < nWorkers; i++) {
+      m_workers.push_back(std::make_unique<Worker>(i, faceFactory));
+    }
+    for (auto& worker : m_workers) {
+      worker->m_trafficPatterns = m_trafficPatterns;
+      worker->m_contentPool = m_contentPool;
+    }
+
+    m_signalSet.async_wait([this] (const boost::system::error_code& ec, int) {
+      if (ec == boost::asio::error::operation_aborted) {
+        return;
+      }
+      if (m_nMaximumInterests && m_nInterestsAdmitted < *m_nMaximumInterests) {
+        m_hasError = true;
+      }
+      stop();
+    });
+    waitForReload();
+
+    if (m_reportInterval) {
+      m_reportStartTime = m_lastReportTime = std::chrono::steady_clock::now();
+      scheduleReport();
+    }
+    m_memoryWatchdog.start([this] (const std::string& error) {
+      m_logger.log("ERROR: " + error, true, true);
+      m_hasError = true;
+      stop();
+    });
+
+    for (std::size_t id = 0; id < m_trafficPatterns.size(); id++) {
+      registerPrefix(*m_workers[id % nWorkers], id);
+    }
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < nWorkers; i++) {
+      threads.emplace_back([this, &worker = *m_workers[i]] {
+        try {
+          placeWorker(worker);
+          m_eventLoopOptions.run(*worker.m_face);
+        }
+        catch (const std::exception& e) {
+          m_logger.log("ERROR: "s + e.what(), true, true);
+          m_hasError = true;
+          boost::asio::post(m_io, [this] { stop(); });
+        }
+      });
+    }
+
+    int exitCode = 0;
+    try {
+      placeWorker(*m_workers.front());
+      m_eventLoopOptions.run(*m_workers.front()->m_face);
+    }
+    catch (const std::exception& e) {
+      m_logger.log("ERROR: "s + e.what(), true, true);
+      shutdownWorkers();
+      m_io.stop();
+      exitCode = 1;
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    if (exitCode != 0) {
+      return exitCode;
+    }
+
+    mergeStatistics();
+    logStatistics();
+    return m_hasError ? 1 : 0;
+  }
+
+private:
+  /**
+   * \brief LRU cache of signed Data packets, keyed by name.
+   *
+   * Signing is by far the most expensive part of answering an Interest, so a pattern
+   * that repeatedly receives Interests for the same names can reuse the already
+   * signed (and wire-encoded) packets instead of creating new ones.
+   */
+  class SignedDataCache
+  {
+  public:
+    SignedDataCache() = default;
+
+    /**
+     * The index holds iterators into the list, so a copy must build its own.
+     */
+    SignedDataCache(const SignedDataCache& other)
+      : m_capacity(other.m_capacity)
+      , m_entries(other.m_entries)
+    {
+      for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        m_index.emplace(it->getName(), it);
+      }
+    }
+
+    // moving a std::list keeps its iterators valid
+    SignedDataCache(SignedDataCache&&) = default;
+
+    SignedDataCache&
+    operator=(const SignedDataCache& other)
+    {
+      if (this != &other) {
+        *this = SignedDataCache(other);
+      }
+      return *this;
+    }
+
+    SignedDataCache&
+    operator=(SignedDataCache&&) = default;
+
+    void
+    setCapacity(std::size_t capacity)
+    {
+      m_capacity = capacity;
+      while (m_entries.size() > m_capacity) {
+        evict();
+      }
+    }
+
+    std::size_t
+    getCapacity() const
+    {
+      return m_capacity;
+    }
+
+    const ndn::Data*
+    find(const ndn::Name& name)
+    {
+      auto it = m_index.find(name);
+      if (it == m_index.end()) {
+        return nullptr;
+      }
+      // move the entry to the front of the recency list
+      m_entries.splice(m_entries.begin(), m_entries, it->second);
+      return &*it->second;
+    }
+
+    void
+    insert(const ndn::Data& data)
+    {
+      if (m_capacity == 0) {
+        return;
+      }
+      if (m_entries.size() >= m_capacity) {
+        evict();
+      }
+      m_entries.push_front(data);
+      m_index.emplace(data.getName(), m_entries.begin());
+    }
+
+  private:
+    void
+    evict()
+    {
+      m_index.erase(m_entries.back().getName());
+      m_entries.pop_back();
+    }
+
+  private:
+    std::size_t m_capacity = 0;
+    std::list<ndn::Data> m_entries; // most recently used first
+    std::unordered_map<ndn::Name, std::list<ndn::Data>::iterator> m_index;
+  };
+
+  /**
+   * \brief Hashed timing wheel that holds delayed Data packets until they are due.
+   *
+   * Each slot covers one tick of the wheel; a packet whose delay is longer than a full
+   * revolution just stays in its slot until the wheel has come around enough times.
+   * Scheduling and expiration are O(1) per packet and a single asio timer is armed at
+   * any given time, regardless of how many responses are outstanding.
+   */
+  class DelayedResponseQueue
+  {
+  public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void(const ndn::Data&)>;
+
+    DelayedResponseQueue(boost::asio::io_context& io, Callback callback)
+      : m_timer(io)
+      , m_callback(std::move(callback))
+      , m_slots(N_SLOTS)
+    {
+    }
+
+    void
+    schedule(ndn::Data data, std::chrono::milliseconds delay)
+    {
+      auto now = Clock::now();
+      if (m_size == 0) {
+        // the wheel is idle, restart it from the current time
+        m_epoch = now;
+        m_currentTick = 0;
+      }
+
+      // round up, so that a packet is never sent before its delay has elapsed
+      auto expiry = std::chrono::ceil<TickDuration>(now - m_epoch + delay).count();
+      auto tick = std::max<uint64_t>(expiry, m_currentTick + 1);
+      m_slots[tick & SLOT_MASK].push_back({tick, std::move(data)});
+
+      if (m_size++ == 0 || tick < m_nextTick) {
+        arm(tick);
+      }
+    }
+
+    std::size_t
+    size() const
+    {
+      return m_size;
+    }
+
+    void
+    cancel()
+    {
+      m_timer.cancel();
+      for (auto& slot : m_slots) {
+        slot.clear();
+      }
+      m_size = 0;
+    }
+
+  private:
+    using TickDuration = std::chrono::milliseconds;
+
+    struct Entry
+    {
+      uint64_t tick;
+      ndn::Data data;
+    };
+
+    void
+    arm(uint64_t tick)
+    {
+      m_nextTick = tick;
+      m_timer.expires_at(m_epoch + TickDuration(tick));
+      m_timer.async_wait([this] (const boost::system::error_code& ec) {
+        if (!ec) {
+          advance();
+        }
+      });
+    }
+
+    void
+    advance()
+    {
+      auto nowTick = static_cast<uint64_t>(
+        std::chrono::duration_cast<TickDuration>(Clock::now() - m_epoch).count());
+
+      while (m_currentTick < nowTick && m_size > 0) {
+        ++m_currentTick;
+        auto& slot = m_slots[m_currentTick & SLOT_MASK];
+        for (std::size_t i = 0; i < slot.size();) {
+          if (slot[i].tick <= m_currentTick) {
+            auto data = std::move(slot[i].data);
+            slot[i] = std::move(slot.back());
+            slot.pop_back();
+            m_size--;
+            m_callback(data);
+          }
+          else {
+            i++;
+          }
+        }
+      }
+
+      if (m_size > 0) {
+        arm(m_currentTick + 1);
+      }
+    }
+
+  private:
+    static constexpr std::size_t N_SLOTS = 1024;
+    static constexpr std::size_t SLOT_MASK = N_SLOTS - 1;
+
+    boost::asio::steady_timer m_timer;
+    Callback m_callback;
+    std::vector<std::vector<Entry>> m_slots;
+    Clock::time_point m_epoch;
+    uint64_t m_currentTick = 0;
+    uint64_t m_nextTick = 0;
+    std::size_t m_size = 0;
+  };
+
+  class DataTrafficConfiguration
+  {
+  public:
+    void
+    printTrafficConfiguration(Logger& logger) const
+    {
+      std::ostringstream os;
+
+      if (!m_name.empty()) {
+        os << "Name=" << m_name << ", ";
+      }
+      if (m_contentDelay >= 0ms) {
+        os << "ContentDelay=" << m_contentDelay.count() << ", ";
+      }
+      if (m_freshnessPeriod >= 0_ms) {
+        os << "FreshnessPeriod=" << m_freshnessPeriod.count() << ", ";
+      }
+      if (m_contentType) {
+        os << "ContentType=" << *m_contentType << ", ";
+      }
+      if (m_contentLength) {
+        os << "ContentBytes=" << *m_contentLength << ", ";
+      }
+      if (!m_content.empty()) {
+        os << "Content=" << m_content << ", ";
+      }
+      if (m_objectLength) {
+        os << "ObjectBytes=" << *m_objectLength << ", SegmentBytes=" << m_segmentLength << ", ";
+      }
+      if (m_signedCache.getCapacity() > 0) {
+        os << "SignedCacheSize=" << m_signedCache.getCapacity() << ", ";
+      }
+      os << "SigningInfo=" << m_signingInfo;
+
+      logger.log(os.str(), false, false);
+    }
+
+    bool
+    parseConfigurationLine(std::string_view line, Logger& logger, int lineNumber)
+    {
+      std::string_view parameter, valueView;
+      if (!extractParameterAndValue(line, parameter, valueView)) {
+        logger.log("Line " + std::to_string(lineNumber) + " - Invalid syntax: " + std::string(line),
+                   false, true);
+        return false;
+      }
+      std::string value(valueView);
+
+      if (parameter == "Name") {
+        m_name = value;
+      }
+      else if (parameter == "ContentDelay") {
+        m_contentDelay = std::chrono::milliseconds(std::stoul(value));
+      }
+      else if (parameter == "FreshnessPeriod") {
+        m_freshnessPeriod = ndn::time::milliseconds(std::stoul(value));
+      }
+      else if (parameter == "ContentType") {
+        m_contentType = std::stoul(value);
+      }
+      else if (parameter == "ContentBytes") {
+        m_contentLength = std::stoul(value);
+      }
+      else if (parameter == "Content") {
+        m_content = value;
+        m_contentBlock = ndn::makeStringBlock(ndn::tlv::Content, m_content);
+      }
+      else if (parameter == "SigningInfo") {
+        m_signingInfo = ndn::security::SigningInfo(value);
+      }
+      else if (parameter == "SignedCacheSize") {
+        m_signedCache.setCapacity(std::stoul(value));
+        m_hasSignedCacheSize = true;
+      }
+      else if (parameter == "ObjectBytes") {
+        m_objectLength = std::stoull(value);
+      }
+      else if (parameter == "SegmentBytes") {
+        m_segmentLength = std::stoul(value);
+      }
+      else {
+        logger.log("Line " + std::to_string(lineNumber) + " - Ignoring unknown parameter: " +
+                   std::string(parameter), false, true);
+      }
+
+      if (m_objectLength && !m_hasSignedCacheSize && m_segmentLength > 0) {
+        // build each segment on its first request only, unless told otherwise
+        auto capacity = std::max<uint64_t>(1, MAX_DEFAULT_SEGMENT_CACHE_BYTES / m_segmentLength);
+        m_signedCache.setCapacity(static_cast<std::size_t>(std::min(getSegmentCount(), capacity)));
+      }
+      return true;
+    }
+
+    /**
+     * \param lineNumber first line of the pattern, for error messages
+     */
+    bool
+    checkTrafficDetailCorrectness(Logger& logger, int lineNumber) const
+    {
+      auto prefix = "Traffic pattern at line " + std::to_string(lineNumber) + " - ";
+      if (m_name.empty()) {
+        logger.log(prefix + "Missing mandatory parameter: Name", false, true);
+        return false;
+      }
+      if (m_objectLength && (*m_objectLength == 0 || m_segmentLength == 0)) {
+        logger.log(prefix + "ObjectBytes and SegmentBytes must be positive", false, true);
+        return false;
+      }
+      if (m_objectLength && (m_contentLength || !m_content.empty())) {
+        logger.log(prefix + "ObjectBytes cannot be combined with ContentBytes or Content", false, true);
+        return false;
+      }
+      // the exact limit, which depends on the Name and the signature, is checked once the key is known
+      if (m_objectLength && m_segmentLength >= ndn::MAX_NDN_PACKET_SIZE) {
+        logger.log(prefix + "SegmentBytes must be less than " + std::to_string(ndn::MAX_NDN_PACKET_SIZE), false, true);
+        return false;
+      }
+      return true;
+    }
+
+    /**
+     * \brief Returns the largest number of random bytes in one Data of this pattern.
+     */
+    std::size_t
+    getRandomContentLength() const
+    {
+      return m_objectLength ? getSegmentLength(0) : m_contentLength.value_or(0);
+    }
+
+    /**
+     * \brief Returns the number of segments of each object (ObjectBytes only).
+     */
+    uint64_t
+    getSegmentCount() const
+    {
+      return (*m_objectLength + m_segmentLength - 1) / m_segmentLength;
+    }
+
+    /**
+     * \brief Returns the content length of segment \p segment (ObjectBytes only).
+     */
+    std::size_t
+    getSegmentLength(uint64_t segment) const
+    {
+      return static_cast<std::size_t>(std::min<uint64_t>(m_segmentLength, *m_objectLength - segment * m_segmentLength));
+    }
+
+    /**
+     * \brief Returns whether Data produced for \p other could also have been produced for this pattern,
+     *        i.e., whether the signed Data cache remains valid across a reload.
+     */
+    bool
+    hasSameContent(const DataTrafficConfiguration& other) const
+    {
+      return m_freshnessPeriod == other.m_freshnessPeriod &&
+             m_contentType == other.m_contentType &&
+             m_contentLength == other.m_contentLength &&
+             m_content == other.m_content &&
+             m_objectLength == other.m_objectLength &&
+             m_segmentLength == other.m_segmentLength &&
+             boost::lexical_cast<std::string>(m_signingInfo) == boost::lexical_cast<std::string>(other.m_signingInfo);
+    }
+
+  private:
+    /// bound on the content bytes held by the default SignedCacheSize of a segmented pattern
+    static constexpr uint64_t MAX_DEFAULT_SEGMENT_CACHE_BYTES = 16 * 1024 * 1024;
+
+  public:
+    std::string m_name;
+    std::chrono::milliseconds m_contentDelay{-1};
+    ndn::time::milliseconds m_freshnessPeriod{-1};
+    std::optional<uint32_t> m_contentType;
+    std::optional<std::size_t> m_contentLength;
+    std::string m_content;
+    ndn::Block m_contentBlock = ndn::makeEmptyBlock(ndn::tlv::Content); ///< pre-encoded m_content
+    ndn::security::SigningInfo m_signingInfo;
+    std::optional<uint64_t> m_objectLength; ///< serve segmented objects of this size
+    std::size_t m_segmentLength = 8000;
+    SignedDataCache m_signedCache;
+    bool m_hasSignedCacheSize = false;
+    bool m_isRemoved = false; ///< no longer in the configuration file since the last reload
+    uint64_t m_nInterestsReceived = 0;
+    uint64_t m_nCacheHits = 0;
+    uint64_t m_nCacheMisses = 0;
+  };
+
+  /**
+   * \brief State of one worker thread.
+   *
+   * Each worker has its own io_context, Face, and KeyChain, and serves a disjoint subset of
+   * the traffic patterns, so the packet processing path never needs any synchronization.
+   * The worker keeps its own copy of the traffic patterns, in which only the patterns it
+   * serves are used, so that a configuration reload never modifies them from another thread.
+   */
+  class Worker : boost::noncopyable
+  {
+  public:
+    Worker(std::size_t id, const FaceFactory& faceFactory, boost::asio::io_context* io = nullptr)
+      : m_id(id)
+      , m_ownIo(io == nullptr ? std::make_unique<boost::asio::io_context>() : nullptr)
+      , m_io(io == nullptr ? *m_ownIo : *io)
+      , m_face(faceFactory ? faceFactory(m_io) : std::make_unique<ndn::Face>(m_io))
+    {
+    }
+
+  public:
+    const std::size_t m_id;
+
+  private:
+    std::unique_ptr<boost::asio::io_context> m_ownIo;
+
+  public:
+    boost::asio::io_context& m_io;
+    std::unique_ptr<ndn::Face> m_face;
+    ndn::KeyChain m_keyChain;
+    DelayedResponseQueue m_delayedResponses{m_io, [this] (const auto& data) {
+      m_face->put(data);
+      m_nDataSent++;
+    }};
+    std::vector<DataTrafficConfiguration> m_trafficPatterns;
+    std::shared_ptr<const std::vector<uint8_t>> m_contentPool;
+    /// by pattern ID; without registration over a UDP transport
+    std::unordered_map<std::size_t, std::variant<ndn::ScopedRegisteredPrefixHandle,
+                                                 ndn::ScopedInterestFilterHandle>> m_registeredPrefixes;
+
+    uint64_t m_nInterestsReceived = 0;
+    uint64_t m_nDataSent = 0;
+    uint64_t m_nCacheHits = 0;
+    uint64_t m_nCacheMisses = 0;
+    bool m_isFinishing = false; ///< no longer accepting Interests, see finish()
+  };
+
+  /**
+   * \brief Counters of all workers at one point in time, for the interval reports.
+   */
+  class CounterSnapshot
+  {
+  public:
+    uint64_t m_nInterestsReceived = 0;
+    uint64_t m_nDataSent = 0;
+    uint64_t m_nDelayedResponses = 0;
+  };
+
+  void
+  mergeStatistics()
+  {
+    for (const auto& worker : m_workers) {
+      // a worker may have stopped before it could apply the last reload
+      auto nPatterns = std::min(m_trafficPatterns.size(), worker->m_trafficPatterns.size());
+      for (std::size_t id = worker->m_id; id < nPatterns; id += m_workers.size()) {
+        const auto& served = worker->m_trafficPatterns[id];
+        auto& pattern = m_trafficPatterns[id];
+        pattern.m_nInterestsReceived = served.m_nInterestsReceived;
+        pattern.m_nCacheHits = served.m_nCacheHits;
+        pattern.m_nCacheMisses = served.m_nCacheMisses;
+      }
+    }
+  }
+
+  void
+  logStatistics()
+  {
+    using std::to_string;
+
+    uint64_t nInterestsReceived = 0;
+    uint64_t nCacheHits = 0;
+    uint64_t nCacheMisses = 0;
+    for (const auto& worker : m_workers) {
+      nInterestsReceived += worker->m_nInterestsReceived;
+      nCacheHits += worker->m_nCacheHits;
+      nCacheMisses += worker->m_nCacheMisses;
+    }
+
+    m_logger.log("\n\n== Traffic Report ==\n", false, true);
+    m_logger.log("Total Traffic Pattern Types = " + to_string(m_trafficPatterns.size()), false, true);
+    if (m_workers.size() > 1) {
+      m_logger.log("Total Worker Threads        = " + to_string(m_workers.size()), false, true);
+    }
+    if (m_transportOptions.m_batchPolicy) {
+      m_logger.log("Average Batch Size          = " + to_string(getBatchStatistics(m_workers).getAverageBatchSize()),
+                   false, true);
+    }
+    m_logger.log("Peak Resident Memory        = " + to_string(getPeakResidentMemory() >> 20) + "MiB", false, true);
+    m_logger.log("Total Interests Received    = " + to_string(nInterestsReceived), false, true);
+    m_logger.log("Signed Data Cache Hits      = " + to_string(nCacheHits), false, true);
+    m_logger.log("Signed Data Cache Misses    = " + to_string(nCacheMisses) + "\n", false, true);
+
+    for (std::size_t patternId = 0; patternId < m_trafficPatterns.size() && !m_wantBrief; patternId++) {
+      const auto& pattern = m_trafficPatterns[patternId];
+
+      m_logger.log("Traffic Pattern Type #" + to_string(patternId + 1) + (pattern.m_isRemoved ? " (removed)" : ""),
+                   false, true);
+      pattern.printTrafficConfiguration(m_logger);
+      m_logger.log("Total Interests Received    = " + to_string(pattern.m_nInterestsReceived), false, true);
+      m_logger.log("Signed Data Cache Hits      = " + to_string(pattern.m_nCacheHits), false, true);
+      m_logger.log("Signed Data Cache Misses    = " + to_string(pattern.m_nCacheMisses) + "\n", false, true);
+    }
+  }
+
+  bool
+  checkTrafficPatternCorrectness(const std::vector<DataTrafficConfiguration>& patterns)
+  {
+    if (patterns.empty()) {
+      m_logger.log("ERROR: No valid traffic pattern found", false, true);
+      return false;
+    }
+
+    // every Interest is dispatched to all matching filters, so a duplicate prefix
+    // would make the server answer twice
+    std::unordered_map<ndn::Name, std::size_t> firstUse;
+    for (std::size_t i = 0; i < patterns.size(); i++) {
+      const auto& pattern = patterns[i];
+      ndn::Name name;
+      try {
+        name = ndn::Name(pattern.m_name);
+      }
+      catch (const std::exception& e) {
+        m_logger.log("ERROR: Traffic Pattern Type #" + std::to_string(i + 1) + " has an invalid Name: " +
+                     pattern.m_name + " (" + e.what() + ")", false, true);
+        return false;
+      }
+      auto [it, isNew] = firstUse.emplace(std::move(name), i);
+      if (!isNew) {
+        m_logger.log("ERROR: Traffic Pattern Type #" + std::to_string(i + 1) + " has the same Name as #" +
+                     std::to_string(it->second + 1) + ": " + pattern.m_name, false, true);
+        return false;
+      }
+    }
+
+    // make sure that every distinct SigningInfo refers to a usable key, rather than
+    // failing on the first Interest
+    std::unique_ptr<ndn::KeyChain> keyChain;
+    try {
+      keyChain = std::make_unique<ndn::KeyChain>();
+    }
+    catch (const std::exception& e) {
+      m_logger.log("ERROR: Cannot open the KeyChain ("s + e.what() + ")", false, true);
+      return false;
+    }
+    std::unordered_set<std::string> checkedSigners;
+    for (std::size_t i = 0; i < patterns.size(); i++) {
+      const auto& info = patterns[i].m_signingInfo;
+      auto [it, isNew] = checkedSigners.insert(boost::lexical_cast<std::string>(info));
+      if (!isNew) {
+        continue;
+      }
+      try {
+        ndn::Data probe("/localhost/ndn-traffic-generator/signing-probe");
+        keyChain->sign(probe, info);
+      }
+      catch (const std::exception& e) {
+        m_logger.log("ERROR: Traffic Pattern Type #" + std::to_string(i + 1) + " has an unusable SigningInfo: " +
+                     *it + " (" + e.what() + ")", false, true);
+        return false;
+      }
+    }
+
+    // the biggest Data of each pattern must fit in one packet, or every Face::put() would throw
+    for (std::size_t i = 0; i < patterns.size(); i++) {
+      const auto& pattern = patterns[i];
+      auto length = pattern.getRandomContentLength();
+      if (length == 0) {
+        continue;
+      }
+      ndn::Name name(pattern.m_name);
+      if (pattern.m_objectLength) {
+        name.appendSegment(pattern.getSegmentCount() - 1);
+      }
+      std::vector<uint8_t> zeros(length);
+      auto size = makeData(*keyChain, zeros, name, pattern, length).wireEncode().size();
+      if (size > ndn::MAX_NDN_PACKET_SIZE) {
+        m_logger.log("ERROR: Traffic Pattern Type #" + std::to_string(i + 1) + " has Data of " +
+                     std::to_string(size) + " bytes, more than the " + std::to_string(ndn::MAX_NDN_PACKET_SIZE) +
+                     " of an NDN packet: reduce " + (pattern.m_objectLength ? "SegmentBytes" : "ContentBytes"),
+                     false, true);
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * \brief Creates the pool of random bytes from which the content of every Data is taken.
+   *
+   * The pool is generated at startup, and again only if a reload needs a bigger one, and is
+   * never modified afterwards, so it can be shared by all workers. It is large enough for the
+   * biggest ContentBytes, or \p minLength if bigger, plus a margin, inside which the starting
+   * offset of each payload is chosen at random.
+   */
+  static std::shared_ptr<const std::vector<uint8_t>>
+  makeContentPool(const std::vector<DataTrafficConfiguration>& patterns, std::size_t minLength)
+  {
+    std::size_t maxLength = minLength;
+    for (const auto& pattern : patterns) {
+      maxLength = std::max(maxLength, pattern.getRandomContentLength());
+    }
+    if (maxLength == 0) {
+      return std::make_shared<const std::vector<uint8_t>>();
+    }
+
+    auto pool = std::make_shared<std::vector<uint8_t>>(maxLength + CONTENT_POOL_MARGIN);
+    auto& rng = ndn::random::getRandomNumberEngine();
+    for (std::size_t i = 0; i < pool->size(); i += sizeof(uint32_t)) {
+      auto word = static_cast<uint32_t>(rng());
+      std::memcpy(pool->data() + i, &word, std::min(sizeof(word), pool->size() - i));
+    }
+    return pool;
+  }
+
+  /**
+   * \brief Returns \p length random bytes, at a random offset of \p pool.
+   */
+  static ndn::span<const uint8_t>
+  getRandomContent(const std::vector<uint8_t>& pool, std::size_t length)
+  {
+    std::uniform_int_distribution<std::size_t> dist(0, pool.size() - length);
+    return ndn::make_span(pool.data() + dist(ndn::random::getRandomNumberEngine()), length);
+  }
+
+  static ndn::Data
+  makeData(ndn::KeyChain& keyChain, const std::vector<uint8_t>& contentPool, const ndn::Name& name,
+           const DataTrafficConfiguration& pattern, std::optional<std::size_t> contentLength = std::nullopt)
+  {
+    ndn::Data data(name);
+
+    if (pattern.m_freshnessPeriod >= 0_ms)
+      data.setFreshnessPeriod(pattern.m_freshnessPeriod);
+
+    if (pattern.m_contentType)
+      data.setContentType(*pattern.m_contentType);
+
+    if (contentLength) {
+      // --size-map
+      if (pattern.m_objectLength) {
+        data.setFinalBlock(ndn::name::Component::fromSegment(pattern.getSegmentCount() - 1));
+      }
+      data.setContent(getRandomContent(contentPool, *contentLength));
+    }
+    else if (pattern.m_objectLength) {
+      // onInterest only accepts segment numbers in range; any other name gets the first segment
+      uint64_t segment = 0;
+      if (!name.empty() && name[-1].isSegment() && name[-1].toSegment() < pattern.getSegmentCount()) {
+        segment = name[-1].toSegment();
+      }
+      data.setFinalBlock(ndn::name::Component::fromSegment(pattern.getSegmentCount() - 1));
+      data.setContent(getRandomContent(contentPool, pattern.getSegmentLength(segment)));
+    }
+    else if (!pattern.m_content.empty())
+      data.setContent(pattern.m_contentBlock);
+    else if (pattern.m_contentLength > 0)
+      data.setContent(getRandomContent(contentPool, *pattern.m_contentLength));
+    else
+      data.setContent(pattern.m_contentBlock);
+
+    keyChain.sign(data, pattern.m_signingInfo);
+    return data;
+  }
+
+  /**
+   * \brief Result of signing the same traffic pattern on one or more threads.
+   */
+  class SigningBenchmarkResult
+  {
+  public:
+    uint64_t m_nPackets = 0;
+    std::chrono::nanoseconds m_elapsed{0}; ///< wall clock, from the first to the last packet
+    uint64_t m_nAllocations = 0;
+    std::string m_error;
+  };
+
+  int
+  runSigningBenchmark()
+  {
+    std::vector<std::size_t> threadCounts{1};
+    if (m_nThreads > 1) {
+      threadCounts.push_back(m_nThreads);
+    }
+
+    m_logger.log("\n\n== Signing Benchmark ==\n", false, true);
+    int exitCode = 0;
+    for (std::size_t patternId = 0; patternId < m_trafficPatterns.size(); patternId++) {
+      const auto& pattern = m_trafficPatterns[patternId];
+      for (auto nThreads : threadCounts) {
+        auto result = benchmarkSigning(pattern, nThreads);
+        auto logLine = "Signing Benchmark  - PatternType=" + std::to_string(patternId + 1) +
+                       ", Name=" + pattern.m_name +
+                       ", SigningInfo=" + boost::lexical_cast<std::string>(pattern.m_signingInfo) +
+                       // a segmented pattern signs whole first segments, see makeData()
+                       (pattern.m_objectLength ? ", SegmentBytes=" : ", ContentBytes=") +
+                       std::to_string(pattern.m_objectLength ? pattern.getRandomContentLength() :
+                                                                 pattern.m_contentLength.value_or(pattern.m_content.size())) +
+                       ", Threads=" + std::to_string(nThreads);
+        if (!result.m_error.empty()) {
+          m_logger.log(logLine + ", ERROR: " + result.m_error, false, true);
+          exitCode = 1;
+          continue;
+        }
+
+        double seconds = std::chrono::duration<double>(result.m_elapsed).count();
+        // per-packet cost on each thread, so that it is comparable across thread counts
+        double nsPerOp = result.m_elapsed.count() * static_cast<double>(nThreads) / result.m_nPackets;
+        m_logger.log(logLine +
+                     ", Packets=" + std::to_string(result.m_nPackets) +
+                     ", NsPerOp=" + std::to_string(nsPerOp) +
+                     ", DataPerSecond=" + std::to_string(seconds > 0.0 ? result.m_nPackets / seconds : 0.0) +
+                     ", AllocationsPerOp=" + std::to_string(static_cast<double>(result.m_nAllocations) /
+                                                            result.m_nPackets),
+                     false, true);
+      }
+    }
+    return exitCode;
+  }
+
+  /**
+   * \brief Makes and signs `--bench-signing` Data packets of \p pattern, split among \p nThreads threads.
+   *
+   * Every packet has a distinct name under the pattern's Name. Each thread uses its own KeyChain,
+   * like the workers, and signs a few packets before the clock starts, so that opening the
+   * KeyChain and loading the key are not measured.
+   */
+  SigningBenchmarkResult
+  benchmarkSigning(const DataTrafficConfiguration& pattern, std::size_t nThreads) const
+  {
+    static constexpr uint64_t N_WARMUP_PACKETS = 16;
+
+    auto nPackets = *m_nBenchmarkPackets;
+    nThreads = static_cast<std::size_t>(std::min<uint64_t>(nThreads, nPackets));
+    ndn::Name prefix(pattern.m_name);
+
+    std::vector<uint64_t> nAllocations(nThreads);
+    std::vector<std::string> errors(nThreads);
+    std::atomic<std::size_t> nReady{0};
+    std::atomic<bool> isStarted{false};
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < nThreads; i++) {
+      threads.emplace_back([&, i] {
+        auto n = nPackets / nThreads + (i < nPackets % nThreads);
+        std::unique_ptr<ndn::KeyChain> keyChain;
+        try {
+          keyChain = std::make_unique<ndn::KeyChain>();
+          for (uint64_t j = 0; j < N_WARMUP_PACKETS; j++) {
+            makeData(*keyChain, *m_contentPool, ndn::Name(prefix).appendSequenceNumber(j), pattern).wireEncode();
+          }
+        }
+        catch (const std::exception& e) {
+          errors[i] = e.what();
+        }
+        nReady++;
+        while (!isStarted) {
+          std::this_thread::yield();
+        }
+        if (keyChain == nullptr) {
+          return;
+        }
+
+        auto allocationsBefore = g_nAllocations;
+        try {
+          for (uint64_t j = 0; j < n; j++) {
+            // the sequence number keeps the names unique across threads
+            auto name = ndn::Name(prefix).appendSequenceNumber(j * nThreads + i);
+            makeData(*keyChain, *m_contentPool, name, pattern).wireEncode();
+          }
+        }
+        catch (const std::exception& e) {
+          errors[i] = e.what();
+        }
+        nAllocations[i] = g_nAllocations - allocationsBefore;
+      });
+    }
+
+    while (nReady < nThreads) {
+      std::this_thread::yield();
+    }
+    auto start = std::chrono::steady_clock::now();
+    isStarted = true;
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    SigningBenchmarkResult result;
+    result.m_elapsed = std::chrono::steady_clock::now() - start;
+    result.m_nPackets = nPackets;
+    for (std::size_t i = 0; i < nThreads; i++) {
+      result.m_nAllocations += nAllocations[i];
+      if (result.m_error.empty()) {
+        result.m_error = errors[i];
+      }
+    }
+    return result;
+  }
+
+  /**
+   * \brief Reserves one of the `--count` responses, if a limit was given.
+   * \return whether the Interest should be answered
+   */
+  bool
+  admitInterest()
+  {
+    if (!m_nMaximumInterests) {
+      return true;
+    }
+
+    auto nAdmitted = m_nInterestsAdmitted.fetch_add(1, std::memory_order_relaxed);
+    if (nAdmitted >= *m_nMaximumInterests) {
+      return false;
+    }
+    if (nAdmitted + 1 == *m_nMaximumInterests) {
+      // this is the last Interest we respond to, let every loop drain and exit
+      boost::asio::post(m_io, [this] { finish(); });
+    }
+    return true;
+  }
+
+  void
+  registerPrefix(Worker& worker, std::size_t patternId)
+  {
+    const auto& name = worker.m_trafficPatterns[patternId].m_name;
+    if (m_isDatagramTransport) {
+      // a forwarder reached over UDP does not accept the registration commands of the Face,
+      // so it must already have a route towards this process: only set the Interest filter
+      worker.m_registeredPrefixes.insert_or_assign(patternId, ndn::ScopedInterestFilterHandle(
+        worker.m_face->setInterestFilter(name, [this, &worker, patternId] (auto&&, const auto& interest) {
+          onInterest(worker, interest, patternId);
+        })));
+      return;
+    }
+    worker.m_registeredPrefixes.insert_or_assign(patternId,
+      worker.m_face->setInterestFilter(name,
+                                      [this, &worker, patternId] (auto&&, const auto& interest) {
+                                        onInterest(worker, interest, patternId);
+                                      },
+                                      nullptr,
+                                      [this, patternId, name] (auto&&, const auto& reason) {
+                                        onRegisterFailed(reason, patternId, name);
+                                      }));
+  }
+
+  void
+  onInterest(Worker& worker, const ndn::Interest& interest, std::size_t patternId)
+  {
+    NDNTG_PROFILE("onInterest");
+    auto& pattern = worker.m_trafficPatterns[patternId];
+
+    if (pattern.m_objectLength) {
+      const auto& name = interest.getName();
+      if (name.empty() || !name[-1].isSegment() || name[-1].toSegment() >= pattern.getSegmentCount()) {
+        // not a segment of an object: let the Interest time out, as for a segment past FinalBlockId
+        return;
+      }
+    }
+
+    if (!admitInterest()) {
+      return;
+    }
+
+    ndn::Data data;
+    if (auto cached = pattern.m_signedCache.find(interest.getName()); cached != nullptr) {
+      data = *cached;
+      worker.m_nCacheHits++;
+      pattern.m_nCacheHits++;
+    }
+    else {
+      std::optional<std::size_t> contentLength;
+      if (m_contentSizes != nullptr) {
+        if (auto it = m_contentSizes->find(interest.getName()); it != m_contentSizes->end()) {
+          contentLength = it->second;
+        }
+      }
+      data = makeData(worker.m_keyChain, *worker.m_contentPool, interest.getName(), pattern, contentLength);
+      pattern.m_signedCache.insert(data);
+      if (pattern.m_signedCache.getCapacity() > 0) {
+        worker.m_nCacheMisses++;
+        pattern.m_nCacheMisses++;
+      }
+    }
+
+    worker.m_nInterestsReceived++;
+    pattern.m_nInterestsReceived++;
+
+    if (!m_wantQuiet) {
+      // the per-worker counters repeat across workers, a process-wide ID needs the shared one
+      auto globalId = m_nInterestsLogged.fetch_add(1, std::memory_order_relaxed) + 1;
+      auto logLine = "Interest Received          - PatternType=" + std::to_string(patternId + 1) +
+                     ", GlobalID=" + std::to_string(globalId) +
+                     ", LocalID=" + std::to_string(pattern.m_nInterestsReceived) +
+                     ", Name=" + interest.getName().toUri();
+      if (m_workers.size() > 1) {
+        logLine += ", Worker=" + std::to_string(worker.m_id + 1);
+      }
+      m_logger.log(logLine, true, false);
+    }
+
+    auto delay = m_contentDelay;
+    if (pattern.m_contentDelay > 0ms)
+      delay += pattern.m_contentDelay;
+
+    if (delay > 0ms) {
+      worker.m_delayedResponses.schedule(std::move(data), delay);
+    }
+    else {
+      worker.m_face->put(data);
+      worker.m_nDataSent++;
+    }
+  }
+
+  void
+  onRegisterFailed(const std::string& reason, std::size_t patternId, const std::string& name)
+  {
+    auto logLine = "Prefix registration failed - PatternType=" + std::to_string(patternId + 1) +
+                   ", Name=" + name +
+                   ", Reason=" + reason;
+    m_logger.log(logLine, true, true);
+
+    boost::asio::post(m_io, [this, patternId] {
+      auto nPatterns = std::count_if(m_trafficPatterns.begin(), m_trafficPatterns.end(),
+                                     [] (const auto& pattern) { return !pattern.m_isRemoved; });
+      m_failedRegistrations.insert(patternId);
+      if (m_failedRegistrations.size() == static_cast<std::size_t>(nPatterns)) {
+        m_hasError = true;
+        stop();
+      }
+    });
+  }
+
+  void
+  waitForReload()
+  {
+    m_reloadSignalSet.async_wait([this] (const boost::system::error_code& ec, int) {
+      if (!ec) {
+        reloadConfiguration();
+        waitForReload();
+      }
+    });
+  }
+
+  /**
+   * \brief Re-reads the configuration file and hands the new traffic patterns to the workers.
+   *
+   * Patterns are identified by their Name: a pattern whose Name is still configured keeps its
+   * number, its statistics, its prefix registration, and, unless the content or signing
+   * parameters changed, its signed Data cache. Removed patterns are unregistered, but remain
+   * in the final report. New patterns are numbered after all existing ones, and are served by
+   * the worker that a pattern with that number would have been assigned at startup. If the new
+   * configuration is invalid, the current one stays in effect.
+   */
+  void
+  reloadConfiguration()
+  {
+    m_logger.log("Reloading traffic configuration file " + m_configurationFile, true, true);
+
+    std::vector<DataTrafficConfiguration> patterns;
+    if (!readConfigurationFile(m_configurationFile, patterns, m_logger) ||
+        !checkTrafficPatternCorrectness(patterns)) {
+      m_logger.log("ERROR: Traffic configuration provided is not proper, keeping the current one", true, true);
+      return;
+    }
+
+    std::unordered_map<ndn::Name, std::size_t> ids;
+    for (std::size_t id = 0; id < m_trafficPatterns.size(); id++) {
+      ids.emplace(m_trafficPatterns[id].m_name, id);
+    }
+
+    auto updated = m_trafficPatterns;
+    for (auto& pattern : updated) {
+      pattern.m_isRemoved = true;
+    }
+    std::size_t nAdded = 0;
+    for (auto& pattern : patterns) {
+      auto it = ids.find(ndn::Name(pattern.m_name));
+      if (it == ids.end()) {
+        updated.push_back(std::move(pattern));
+        nAdded++;
+      }
+      else {
+        updated[it->second] = std::move(pattern);
+      }
+    }
+
+    std::size_t nRemoved = 0;
+    for (std::size_t id = 0; id < m_trafficPatterns.size(); id++) {
+      nRemoved += !m_trafficPatterns[id].m_isRemoved && updated[id].m_isRemoved;
+    }
+    m_trafficPatterns = std::move(updated);
+    // a removed pattern is registered again if it comes back
+    for (auto it = m_failedRegistrations.begin(); it != m_failedRegistrations.end();) {
+      it = m_trafficPatterns[*it].m_isRemoved ? m_failedRegistrations.erase(it) : std::next(it);
+    }
+
+    // the workers use the current pool until they apply the new configuration, so it is replaced, never resized
+    std::size_t maxLength = 0;
+    for (const auto& pattern : m_trafficPatterns) {
+      maxLength = std::max(maxLength, pattern.getRandomContentLength());
+    }
+    if (maxLength > 0 && maxLength + CONTENT_POOL_MARGIN > m_contentPool->size()) {
+      m_contentPool = makeContentPool(m_trafficPatterns, m_maxMappedContentLength);
+    }
+
+    m_logger.log("Traffic configuration reloaded - Patterns=" + std::to_string(patterns.size()) +
+                 ", Added=" + std::to_string(nAdded) + ", Removed=" + std::to_string(nRemoved), true, true);
+    for (std::size_t id = 0; id < m_trafficPatterns.size() && !m_wantBrief; id++) {
+      if (!m_trafficPatterns[id].m_isRemoved) {
+        m_logger.log("Traffic Pattern Type #" + std::to_string(id + 1), false, false);
+        m_trafficPatterns[id].printTrafficConfiguration(m_logger);
+      }
+    }
+
+    auto snapshot = std::make_shared<const std::vector<DataTrafficConfiguration>>(m_trafficPatterns);
+    for (auto& worker : m_workers) {
+      boost::asio::post(worker->m_io, [this, snapshot, contentPool = m_contentPool, &worker = *worker] {
+        applyConfiguration(worker, *snapshot, contentPool);
+      });
+    }
+  }
+
+  /**
+   * \brief Installs a reloaded configuration, on the worker's own thread.
+   *
+   * Only the prefixes of added and removed patterns are registered or unregistered.
+   */
+  void
+  applyConfiguration(Worker& worker, const std::vector<DataTrafficConfiguration>& patterns,
+                     std::shared_ptr<const std::vector<uint8_t>> contentPool)
+  {
+    if (worker.m_isFinishing) {
+      return;
+    }
+
+    if (m_eventLoopOptions.m_cpus.empty()) {
+      worker.m_contentPool = std::move(contentPool);
+    }
+    else if (contentPool->size() > worker.m_contentPool->size()) {
+      // keep a copy on the NUMA node of the worker, see placeWorker()
+      worker.m_contentPool = std::make_shared<const std::vector<uint8_t>>(*contentPool);
+    }
+    auto old = std::exchange(worker.m_trafficPatterns, patterns);
+    for (std::size_t id = worker.m_id; id < worker.m_trafficPatterns.size(); id += m_workers.size()) {
+      auto& pattern = worker.m_trafficPatterns[id];
+      bool wasServed = id < old.size() && !old[id].m_isRemoved;
+      if (id < old.size()) {
+        pattern.m_nInterestsReceived = old[id].m_nInterestsReceived;
+        pattern.m_nCacheHits = old[id].m_nCacheHits;
+        pattern.m_nCacheMisses = old[id].m_nCacheMisses;
+        if (pattern.hasSameContent(old[id])) {
+          auto capacity = pattern.m_signedCache.getCapacity();
+          pattern.m_signedCache = std::move(old[id].m_signedCache);
+          pattern.m_signedCache.setCapacity(capacity);
+        }
+      }
+
+      if (pattern.m_isRemoved && wasServed) {
+        worker.m_registeredPrefixes.erase(id);
+      }
+      else if (!pattern.m_isRemoved && !wasServed) {
+        registerPrefix(worker, id);
+      }
+    }
+  }
+
+  /**
+   * \brief Stops accepting Interests, but lets pending delayed responses go out.
+   */
+  void
+  finish()
+  {
+    for (auto& worker : m_workers) {
+      boost::asio::post(worker->m_io, [&worker = *worker] {
+        worker.m_isFinishing = true;
+        worker.m_registeredPrefixes.clear();
+      });
+    }
+    m_signalSet.cancel();
+    m_reloadSignalSet.cancel();
+    m_reportTimer.cancel();
+    m_memoryWatchdog.cancel();
+    if (m_metricsServer) {
+      m_metricsServer->close();
+    }
+  }
+
+  void
+  scheduleReport()
+  {
+    m_reportTimer.expires_after(*m_reportInterval);
+    m_reportTimer.async_wait([this] (const boost::system::error_code& ec) {
+      if (!ec) {
+        collectReport();
+        scheduleReport();
+      }
+    });
+  }
+
+  /**
+   * \brief Reads each worker's counters, on its own thread, and reports the difference
+   *        between their sum and the sum at the previous report.
+   */
+  void
+  collectReport()
+  {
+    auto total = std::make_shared<CounterSnapshot>();
+    auto nPending = std::make_shared<std::size_t>(m_workers.size());
+    for (auto& worker : m_workers) {
+      boost::asio::post(worker->m_io, [this, total, nPending, &worker = *worker] {
+        CounterSnapshot snapshot{worker.m_nInterestsReceived, worker.m_nDataSent,
+                                 worker.m_delayedResponses.size()};
+        boost::asio::post(m_io, [this, total, nPending, snapshot] {
+          total->m_nInterestsReceived += snapshot.m_nInterestsReceived;
+          total->m_nDataSent += snapshot.m_nDataSent;
+          total->m_nDelayedResponses += snapshot.m_nDelayedResponses;
+          if (--*nPending == 0) {
+            logIntervalReport(*total);
+          }
+        });
+      });
+    }
+  }
+
+  void
+  logIntervalReport(const CounterSnapshot& current)
+  {
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - m_lastReportTime).count();
+    auto previous = std::exchange(m_lastReportCounters, current);
+    m_lastReportTime = now;
+    if (!(elapsed > 0.0)) {
+      return;
+    }
+
+    m_intervalReporter.report(m_logger, {
+      {"Time", std::chrono::duration<double>(now - m_reportStartTime).count()},
+      {"InterestsPerSecond", (current.m_nInterestsReceived - previous.m_nInterestsReceived) / elapsed},
+      {"DataPerSecond", (current.m_nDataSent - previous.m_nDataSent) / elapsed},
+      {"DelayedResponses", static_cast<double>(current.m_nDelayedResponses)},
+      {"ResidentMemoryMiB", getResidentMemory() / 1048576.0},
+    });
+  }
+
+  /**
+   * \brief Cumulative counters of one traffic pattern, as exported to the metrics endpoint.
+   */
+  class PatternCounters
+  {
+  public:
+    uint64_t m_nInterestsReceived = 0;
+    uint64_t m_nCacheHits = 0;
+    uint64_t m_nCacheMisses = 0;
+  };
+
+  /**
+   * \brief Reads the counters of each worker, and of the patterns it serves, on the worker's
+   *        own thread, and replies with the result.
+   */
+  void
+  collectMetrics(MetricsServer::Reply reply)
+  {
+    auto patterns = std::make_shared<std::vector<PatternCounters>>(m_trafficPatterns.size());
+    auto total = std::make_shared<CounterSnapshot>();
+    auto nPending = std::make_shared<std::size_t>(m_workers.size());
+    for (auto& worker : m_workers) {
+      boost::asio::post(worker->m_io, [=, &worker = *worker] {
+        std::vector<std::pair<std::size_t, PatternCounters>> owned;
+        for (std::size_t id = worker.m_id; id < worker.m_trafficPatterns.size(); id += m_workers.size()) {
+          const auto& pattern = worker.m_trafficPatterns[id];
+          owned.push_back({id, {pattern.m_nInterestsReceived, pattern.m_nCacheHits, pattern.m_nCacheMisses}});
+        }
+        CounterSnapshot snapshot{worker.m_nInterestsReceived, worker.m_nDataSent,
+                                 worker.m_delayedResponses.size()};
+        boost::asio::post(m_io, [=, owned = std::move(owned)] {
+          for (const auto& [id, counters] : owned) {
+            // the worker may have applied a reload that happened after the scrape started
+            if (id < patterns->size()) {
+              (*patterns)[id] = counters;
+            }
+          }
+          total->m_nInterestsReceived += snapshot.m_nInterestsReceived;
+          total->m_nDataSent += snapshot.m_nDataSent;
+          total->m_nDelayedResponses += snapshot.m_nDelayedResponses;
+          if (--*nPending == 0) {
+            reply(formatMetrics(*patterns, *total));
+          }
+        });
+      });
+    }
+  }
+
+  std::string
+  formatMetrics(const std::vector<PatternCounters>& patterns, const CounterSnapshot& total) const
+  {
+    std::ostringstream os;
+    auto addCounter = [&] (const char* name, const char* help, uint64_t PatternCounters::* member) {
+      os << "# HELP " << name << ' ' << help << "\n"
+         << "# TYPE " << name << " counter\n";
+      for (std::size_t id = 0; id < patterns.size(); id++) {
+        os << name << "{pattern=\"" << id + 1 << "\",name=\""
+           << MetricsServer::escapeLabelValue(m_trafficPatterns[id].m_name) << "\"} "
+           << patterns[id].*member << "\n";
+      }
+    };
+
+    addCounter("ndntg_server_interests_received_total", "Interests received", &PatternCounters::m_nInterestsReceived);
+    addCounter("ndntg_server_cache_hits_total", "Responses taken from the signed Data cache",
+               &PatternCounters::m_nCacheHits);
+    addCounter("ndntg_server_cache_misses_total", "Responses signed and added to the signed Data cache",
+               &PatternCounters::m_nCacheMisses);
+    os << "# HELP ndntg_server_data_sent_total Data packets sent\n"
+       << "# TYPE ndntg_server_data_sent_total counter\n"
+       << "ndntg_server_data_sent_total " << total.m_nDataSent << "\n"
+       << "# HELP ndntg_server_delayed_responses Data packets waiting for their delay to elapse\n"
+       << "# TYPE ndntg_server_delayed_responses gauge\n"
+       << "ndntg_server_delayed_responses " << total.m_nDelayedResponses << "\n";
+    return os.str();
+  }
+
+  /**
+   * \brief Binds the calling thread, which runs \p worker, to its CPU of --cpu-affinity, and
+   *        gives the worker a copy of the content pool on the NUMA node of that CPU.
+   * \throw std::runtime_error
+   */
+  void
+  placeWorker(Worker& worker)
+  {
+    auto placement = m_eventLoopOptions.placeWorker(worker.m_id);
+    if (!placement) {
+      return;
+    }
+    worker.m_contentPool = std::make_shared<const std::vector<uint8_t>>(*worker.m_contentPool);
+    m_logger.log("Worker #" + std::to_string(worker.m_id + 1) + " runs on " + *placement, true, false);
+  }
+
+  /**
+   * \brief Returns the most bytes that any traffic pattern adds to a name and a content of
+   *        the same total size, to make a signed Data.
+   */
+  static std::size_t
+  getMaxDataOverhead(ndn::KeyChain& keyChain, const std::vector<DataTrafficConfiguration>& patterns)
+  {
+    const std::vector<uint8_t> none;
+    std::size_t overhead = 0;
+    for (const auto& pattern : patterns) {
+      ndn::Name name(pattern.m_name);
+      auto size = makeData(keyChain, none, name, pattern, 0).wireEncode().size();
+      overhead = std::max(overhead, size - name.wireEncode().size());
+    }
+    // longer TLV-LENGTH fields of Content, Name and Data, and signatures of varying size
+    return overhead + DATA_OVERHEAD_MARGIN;
+  }
+
+  bool
+  readContentSizeMap()
+  {
+    MappedFile file(m_contentSizeFile);
+    if (!file) {
+      m_logger.log("ERROR: Unable to open content size map: " + m_contentSizeFile, false, true);
+      return false;
+    }
+
+    // a length that does not fit in one Data would make every Face::put() of that name throw
+    std::size_t overhead = 0;
+    try {
+      ndn::KeyChain keyChain;
+      overhead = getMaxDataOverhead(keyChain, m_trafficPatterns);
+    }
+    catch (const std::exception& e) {
+      m_logger.log("ERROR: Cannot sign Data for the content size map ("s + e.what() + ")", false, true);
+      return false;
+    }
+
+    auto sizes = std::make_shared<std::unordered_map<ndn::Name, std::size_t>>();
+    auto contents = file.getContents();
+    int lineNumber = 0;
+    while (!contents.empty()) {
+      auto endOfLine = contents.find('\n');
+      std::string line(contents.substr(0, endOfLine));
+      contents.remove_prefix(endOfLine == std::string_view::npos ? contents.size() : endOfLine + 1);
+      lineNumber++;
+      if (line.empty() || line.front() == '#' || line.find_first_not_of(" \t\r") == std::string::npos) {
+        continue;
+      }
+
+      std::istringstream is(line);
+      std::string uri;
+      std::size_t length = 0;
+      try {
+        if (!(is >> uri >> length) || !(is >> std::ws).eof()) {
+          throw std::invalid_argument("expecting a name and a length");
+        }
+        ndn::Name name(uri);
+        auto nameSize = name.wireEncode().size();
+        if (length > ndn::MAX_NDN_PACKET_SIZE || nameSize + length + overhead > ndn::MAX_NDN_PACKET_SIZE) {
+          throw std::invalid_argument("the Data would be larger than the " +
+                                      std::to_string(ndn::MAX_NDN_PACKET_SIZE) + " bytes of an NDN packet");
+        }
+        (*sizes)[std::move(name)] = length;
+      }
+      catch (const std::exception& e) {
+        m_logger.log("ERROR: " + m_contentSizeFile + " line " + std::to_string(lineNumber) + " - Invalid value: " +
+                     line + " (" + e.what() + ")", false, true);
+        return false;
+      }
+      m_maxMappedContentLength = std::max(m_maxMappedContentLength, length);
+    }
+
+    m_logger.log("Read " + std::to_string(sizes->size()) + " content sizes from " + m_contentSizeFile, true, true);
+    m_contentSizes = std::move(sizes);
+    return true;
+  }
+
+  void
+  shutdownWorkers()
+  {
+    for (auto& worker : m_workers) {
+      boost::asio::post(worker->m_io, [&worker = *worker] {
+        worker.m_registeredPrefixes.clear();
+        worker.m_delayedResponses.cancel();
+        worker.m_face->shutdown();
+        worker.m_io.stop();
+      });
+    }
+  }
+
+  void
+  stop()
+  {
+    m_signalSet.cancel();
+    m_reloadSignalSet.cancel();
+    m_reportTimer.cancel();
+    m_memoryWatchdog.cancel();
+    if (m_metricsServer) {
+      m_metricsServer->close();
+    }
+    shutdownWorkers();
+  }
+
+private:
+  static constexpr std::size_t CONTENT_POOL_MARGIN = 64 * 1024;
+  static constexpr std::size_t DATA_OVERHEAD_MARGIN = 16;
+
+  Logger m_logger{"NdnTrafficServer"};
+  boost::asio::io_context m_io;
+  boost::asio::signal_set m_signalSet{m_io, SIGINT, SIGTERM};
+  boost::asio::signal_set m_reloadSignalSet{m_io, SIGHUP};
+  boost::asio::steady_timer m_reportTimer{m_io};
+  MemoryWatchdog m_memoryWatchdog{m_io};
+
+  std::string m_configurationFile;
+  std::string m_timestampFormat;
+  std::optional<uint64_t> m_nMaximumInterests;
+  std::chrono::milliseconds m_contentDelay{0};
+  std::size_t m_nThreads = 1;
+  std::optional<uint64_t> m_nBenchmarkPackets;
+  std::optional<std::chrono::nanoseconds> m_reportInterval;
+  IntervalReporter m_intervalReporter;
+  std::chrono::steady_clock::time_point m_reportStartTime;
+  std::chrono::steady_clock::time_point m_lastReportTime;
+  CounterSnapshot m_lastReportCounters;
+  std::optional<boost::asio::ip::tcp::endpoint> m_metricsEndpoint;
+  TransportOptions m_transportOptions;
+  bool m_isDatagramTransport = false;
+  FaceFactory m_faceFactory;
+  EventLoopOptions m_eventLoopOptions;
+  std::unique_ptr<MetricsServer> m_metricsServer;
+
+  std::vector<DataTrafficConfiguration> m_trafficPatterns;
+  std::shared_ptr<const std::vector<uint8_t>> m_contentPool;
+  std::string m_contentSizeFile;
+  std::shared_ptr<const std::unordered_map<ndn::Name, std::size_t>> m_contentSizes; ///< read-only once running
+  std::size_t m_maxMappedContentLength = 0;
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  std::unordered_set<std::size_t> m_failedRegistrations; ///< IDs of the configured patterns
+  std::atomic<uint64_t> m_nInterestsAdmitted{0};
+  std::atomic<uint64_t> m_nInterestsLogged{0}; ///< GlobalID of the Interest Received log lines
+
+  bool m_wantQuiet = false;
+  bool m_wantAsyncLogging = false;
+  bool m_wantBrief = false;
+  std::atomic<bool> m_hasError{false};
+};
+
+} // namespace ndntg
+
+#endif // NDNTG_NDN_TRAFFIC_SERVER_HPP
@@ -0,0 +1,189 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2023, Arizona Board of Regents.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "replay.hpp"
+#include "trace.hpp"
+
+#include <ndn-cxx/data.hpp>
+#include <ndn-cxx/lp/nack-header.hpp>
+
+#include <cstdio>
+#include <iostream>
+#include <unordered_set>
+
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/variables_map.hpp>
+
+namespace ndntg {
+
+static std::string
+quoteCsv(const std::string& field)
+{
+  std::string quoted = "\"";
+  for (char c : field) {
+    if (c == '"') {
+      quoted += '"';
+    }
+    quoted += c;
+  }
+  return quoted + '"';
+}
+
+static void
+dumpTrace(trace::TraceReader& reader, std::ostream& os)
+{
+  const auto& names = reader.getPatternNames();
+  std::vector<std::string> quotedNames;
+  for (const auto& name : names) {
+    quotedNames.push_back(quoteCsv(name));
+  }
+
+  os << "Event,PatternType,Name,GlobalID,LocalID,Nonce,SendTime,ReceiveTime,RTT,NackReason\n";
+
+  std::vector<trace::TraceRecord> records;
+  while (reader.read(records)) {
+    for (const auto& r : records) {
+      char nonce[9];
+      const auto* b = reinterpret_cast<const uint8_t*>(&r.m_nonce);
+      std::snprintf(nonce, sizeof(nonce), "%02x%02x%02x%02x", b[0], b[1], b[2], b[3]);
+
+      os << trace::toString(r.m_type) << ','
+         << r.m_patternId + 1 << ','
+         << (r.m_patternId < quotedNames.size() ? quotedNames[r.m_patternId] : "") << ','
+         << r.m_globalId << ','
+         << r.m_localId << ','
+         << nonce << ','
+         << r.m_sendTime << ',';
+      if (r.m_type != trace::EventType::INTEREST_SENT) {
+        os << r.m_receiveTime;
+      }
+      os << ',';
+      if (r.m_type == trace::EventType::DATA_RECEIVED || r.m_type == trace::EventType::LATE_DATA_RECEIVED) {
+        os << (r.m_receiveTime - r.m_sendTime) / 1e6;
+      }
+      os << ',';
+      if (r.m_type == trace::EventType::NACK_RECEIVED) {
+        os << static_cast<ndn::lp::NackReason>(r.m_nackReason);
+      }
+      os << '\n';
+    }
+  }
+}
+
+/**
+ * \brief Prints the name and the content length of the first Data of every name in a pcap
+ *        capture, in the format of ndn-traffic-server --size-map.
+ */
+static void
+dumpSizeMap(ReplayReader& reader, std::ostream& os)
+{
+  if (reader.getFormat() != ReplayReader::Format::PCAP) {
+    throw std::runtime_error("--size-map needs a pcap capture");
+  }
+
+  std::unordered_set<ndn::Name> names;
+  ReplayEvent event;
+  while (reader.next(event)) {
+    if (event.m_packet.type() != ndn::tlv::Data) {
+      continue;
+    }
+    ndn::Data data(event.m_packet);
+    if (names.insert(data.getName()).second) {
+      os << data.getName() << ' ' << data.getContent().value_size() << '\n';
+    }
+  }
+}
+
+} // namespace ndntg
+
+namespace po = boost::program_options;
+
+static void
+usage(std::ostream& os, std::string_view programName, const po::options_description& desc)
+{
+  os << "Usage: " << programName << " [options] <Trace_File>\n"
+     << "       " << programName << " --size-map <Pcap_File>\n"
+     << "\n"
+     << "Convert a binary trace written by ndn-traffic-client --trace-file to CSV on standard output.\n"
+     << "Times are steady clock nanoseconds, RTT is in milliseconds.\n"
+     << "With --size-map, list the content length of the Data in a pcap capture instead.\n"
+     << "\n"
+     << desc;
+}
+
+int
+main(int argc, char* argv[])
+{
+  std::string traceFile;
+
+  po::options_description visibleOptions("Options");
+  visibleOptions.add_options()
+    ("help,h", "print this help message and exit")
+    ("size-map", po::bool_switch(),
+               "print 'NAME LENGTH' for the first Data of every name in a pcap capture, "
+               "for ndn-traffic-server --size-map")
+    ;
+
+  po::options_description hiddenOptions;
+  hiddenOptions.add_options()
+    ("trace-file", po::value<std::string>(&traceFile))
+    ;
+
+  po::positional_options_description posOptions;
+  posOptions.add("trace-file", -1);
+
+  po::options_description allOptions;
+  allOptions.add(visibleOptions).add(hiddenOptions);
+
+  po::variables_map vm;
+  try {
+    po::store(po::command_line_parser(argc, argv).options(allOptions).positional(posOptions).run(), vm);
+    po::notify(vm);
+  }
+  catch (const po::error& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 2;
+  }
+
+  if (vm.count("help") > 0) {
+    usage(std::cout, argv[0], visibleOptions);
+    return 0;
+  }
+
+  if (traceFile.empty()) {
+    usage(std::cerr, argv[0], visibleOptions);
+    return 2;
+  }
+
+  try {
+    if (vm["size-map"].as<bool>()) {
+      ndntg::ReplayReader reader(traceFile);
+      ndntg::dumpSizeMap(reader, std::cout);
+    }
+    else {
+      ndntg::trace::TraceReader reader(traceFile);
+      ndntg::dumpTrace(reader, std::cout);
+    }
+  }
+  catch (const std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
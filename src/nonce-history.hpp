@@ -0,0 +1,170 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2023, Arizona Board of Regents.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NDNTG_NONCE_HISTORY_HPP
+#define NDNTG_NONCE_HISTORY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <boost/assert.hpp>
+
+namespace ndntg {
+
+/**
+ * \brief Sliding window of the most recently used nonces.
+ *
+ * The nonces are kept in insertion order in a ring buffer, which makes eviction of the
+ * oldest one and uniform sampling trivial, and are indexed by an open-addressing hash
+ * set with linear probing, which makes membership tests O(1) on average.
+ * The set is sized to at most 50% load, and uses backward-shift deletion so that no
+ * tombstones ever accumulate.
+ */
+class NonceHistory
+{
+public:
+  explicit
+  NonceHistory(std::size_t capacity = 1000)
+    : m_ring(capacity)
+  {
+    BOOST_ASSERT(capacity > 0);
+
+    std::size_t nSlots = 1;
+    m_shift = 64;
+    while (nSlots < capacity * 2) {
+      nSlots <<= 1;
+      m_shift--;
+    }
+    m_slots.resize(nSlots, EMPTY);
+    m_mask = nSlots - 1;
+  }
+
+  std::size_t
+  size() const
+  {
+    return m_size;
+  }
+
+  bool
+  empty() const
+  {
+    return m_size == 0;
+  }
+
+  bool
+  contains(uint32_t nonce) const
+  {
+    for (auto i = home(nonce); m_slots[i] != EMPTY; i = (i + 1) & m_mask) {
+      if (m_slots[i] == toSlot(nonce)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * \brief Adds a nonce, evicting the oldest one if the window is full.
+   * \pre !contains(nonce)
+   */
+  void
+  insert(uint32_t nonce)
+  {
+    if (m_size == m_ring.size()) {
+      // overwrite the oldest nonce
+      erase(m_ring[m_head]);
+      m_ring[m_head] = nonce;
+      m_head = (m_head + 1) % m_ring.size();
+    }
+    else {
+      m_ring[(m_head + m_size) % m_ring.size()] = nonce;
+      m_size++;
+    }
+
+    auto i = home(nonce);
+    while (m_slots[i] != EMPTY) {
+      i = (i + 1) & m_mask;
+    }
+    m_slots[i] = toSlot(nonce);
+  }
+
+  /**
+   * \brief Returns one of the nonces in the window, chosen uniformly at random.
+   * \pre !empty()
+   */
+  template<typename RandomEngine>
+  uint32_t
+  sample(RandomEngine& rng) const
+  {
+    BOOST_ASSERT(m_size > 0);
+    std::uniform_int_distribution<std::size_t> dist(0, m_size - 1);
+    return m_ring[(m_head + dist(rng)) % m_ring.size()];
+  }
+
+private:
+  // slots store the nonce in the low 32 bits and an "occupied" flag above them
+  static constexpr uint64_t EMPTY = 0;
+
+  static uint64_t
+  toSlot(uint32_t nonce)
+  {
+    return (uint64_t{1} << 32) | nonce;
+  }
+
+  std::size_t
+  home(uint32_t nonce) const
+  {
+    // Fibonacci hashing
+    return static_cast<std::size_t>((uint64_t{nonce} * UINT64_C(0x9E3779B97F4A7C15)) >> m_shift) & m_mask;
+  }
+
+  void
+  erase(uint32_t nonce)
+  {
+    auto i = home(nonce);
+    while (m_slots[i] != toSlot(nonce)) {
+      BOOST_ASSERT(m_slots[i] != EMPTY);
+      i = (i + 1) & m_mask;
+    }
+
+    // shift back the following entries of the cluster that would become unreachable
+    for (auto j = (i + 1) & m_mask; m_slots[j] != EMPTY; j = (j + 1) & m_mask) {
+      auto k = home(static_cast<uint32_t>(m_slots[j]));
+      bool canMove = i <= j ? (k <= i || k > j) : (k <= i && k > j);
+      if (canMove) {
+        m_slots[i] = m_slots[j];
+        i = j;
+      }
+    }
+    m_slots[i] = EMPTY;
+  }
+
+private:
+  std::vector<uint32_t> m_ring;
+  std::size_t m_head = 0; ///< position of the oldest nonce
+  std::size_t m_size = 0;
+
+  std::vector<uint64_t> m_slots;
+  std::size_t m_mask = 0;
+  unsigned m_shift = 64;
+};
+
+} // namespace ndntg
+
+#endif // NDNTG_NONCE_HISTORY_HPP
@@ -0,0 +1,147 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2023, Arizona Board of Regents.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NDNTG_PROFILER_HPP
+#define NDNTG_PROFILER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+
+namespace ndntg {
+namespace profile {
+
+/**
+ * \brief Call count and cumulative wall-clock time of one profiled section of code.
+ *
+ * Sections are only created by NDNTG_PROFILE, as function-local statics, and register
+ * themselves on their first use; they can then be updated from any thread.
+ */
+class Section : boost::noncopyable
+{
+public:
+  explicit
+  Section(const char* name)
+    : m_name(name)
+  {
+    std::lock_guard<std::mutex> lock(getMutex());
+    getRegistry().push_back(this);
+  }
+
+  void
+  add(std::chrono::nanoseconds elapsed)
+  {
+    m_nCalls.fetch_add(1, std::memory_order_relaxed);
+    m_totalTime.fetch_add(static_cast<uint64_t>(elapsed.count()), std::memory_order_relaxed);
+  }
+
+  const char*
+  getName() const
+  {
+    return m_name;
+  }
+
+  uint64_t
+  getCalls() const
+  {
+    return m_nCalls.load(std::memory_order_relaxed);
+  }
+
+  std::chrono::nanoseconds
+  getTotalTime() const
+  {
+    return std::chrono::nanoseconds(m_totalTime.load(std::memory_order_relaxed));
+  }
+
+  /**
+   * \brief Returns every section used so far, in the order of their first use.
+   */
+  static std::vector<const Section*>
+  getAll()
+  {
+    std::lock_guard<std::mutex> lock(getMutex());
+    return {getRegistry().begin(), getRegistry().end()};
+  }
+
+private:
+  static std::mutex&
+  getMutex()
+  {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+  static std::vector<Section*>&
+  getRegistry()
+  {
+    static std::vector<Section*> registry;
+    return registry;
+  }
+
+private:
+  const char* m_name;
+  std::atomic<uint64_t> m_nCalls{0};
+  std::atomic<uint64_t> m_totalTime{0}; ///< nanoseconds
+};
+
+/**
+ * \brief Adds the lifetime of the object to a Section.
+ */
+class ScopedTimer : boost::noncopyable
+{
+public:
+  explicit
+  ScopedTimer(Section& section)
+    : m_section(section)
+    , m_start(std::chrono::steady_clock::now())
+  {
+  }
+
+  ~ScopedTimer()
+  {
+    m_section.add(std::chrono::steady_clock::now() - m_start);
+  }
+
+private:
+  Section& m_section;
+  std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace profile
+} // namespace ndntg
+
+/**
+ * \brief Profiles the rest of the enclosing scope under \p name.
+ *
+ * This expands to nothing unless NDNTG_WITH_PROFILING is defined, which only the
+ * ndn-traffic-benchmark target does, so the tools themselves never pay for the two
+ * clock reads per call.
+ */
+#ifdef NDNTG_WITH_PROFILING
+#define NDNTG_PROFILE(name) \
+  static ::ndntg::profile::Section ndntgProfileSection(name); \
+  ::ndntg::profile::ScopedTimer ndntgProfileTimer(ndntgProfileSection)
+#else
+#define NDNTG_PROFILE(name) do {} while (false)
+#endif
+
+#endif // NDNTG_PROFILER_HPP
@@ -0,0 +1,445 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2023, Arizona Board of Regents.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NDNTG_REPLAY_HPP
+#define NDNTG_REPLAY_HPP
+
+#include "trace.hpp"
+#include "util.hpp"
+
+#include <ndn-cxx/encoding/block.hpp>
+#include <ndn-cxx/encoding/tlv.hpp>
+#include <ndn-cxx/lp/fields.hpp>
+#include <ndn-cxx/lp/packet.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+
+namespace ndntg {
+
+/**
+ * \brief One packet of a recorded trace, as returned by ReplayReader.
+ */
+class ReplayEvent
+{
+public:
+  std::chrono::nanoseconds m_time{0}; ///< since the first event of the trace
+  ndn::Block m_packet;                ///< pcap: the Interest or Data, without its NDNLP header
+  std::size_t m_patternId = 0;        ///< binary trace: index in ReplayReader::getPatternNames()
+};
+
+/**
+ * \brief Reads the packets of a pcap capture, or the Interests of a binary trace written by
+ *        `ndn-traffic-client --trace-file`, in the order in which they were recorded.
+ *
+ * The file is memory-mapped and read from start to end, and the pages that have been read are
+ * released on the way, so a trace of any size can be replayed with a small, constant amount of
+ * memory. In a pcap file, NDN packets are recognized over Ethernet (EtherType 0x8624) and over
+ * UDP, on port 6363 or 56363, in IPv4 and IPv6; NDN over TCP and fragmented packets are skipped.
+ */
+class ReplayReader : boost::noncopyable
+{
+public:
+  enum class Format {
+    PCAP,
+    TRACE,
+  };
+
+  /**
+   * \throw std::runtime_error the file cannot be opened or is neither a pcap nor a binary trace
+   */
+  explicit
+  ReplayReader(const std::string& filename)
+    : m_file(filename)
+  {
+    if (!m_file) {
+      throw std::runtime_error("cannot open " + filename);
+    }
+    m_contents = m_file.getContents();
+
+    if (m_contents.size() >= sizeof(trace::MAGIC) &&
+        std::memcmp(m_contents.data(), trace::MAGIC, sizeof(trace::MAGIC)) == 0) {
+      m_format = Format::TRACE;
+      readTraceHeader();
+      return;
+    }
+
+    if (m_contents.size() < PCAP_HEADER_SIZE) {
+      throw std::runtime_error(filename + " is neither a pcap file nor a trace file");
+    }
+    uint32_t magic = 0;
+    std::memcpy(&magic, m_contents.data(), sizeof(magic));
+    switch (magic) {
+      case 0xa1b2c3d4:
+        break;
+      case 0xd4c3b2a1:
+        m_isSwapped = true;
+        break;
+      case 0xa1b23c4d:
+        m_isNanosecond = true;
+        break;
+      case 0x4d3cb2a1:
+        m_isSwapped = m_isNanosecond = true;
+        break;
+      default:
+        throw std::runtime_error(filename + " is neither a pcap file nor a trace file");
+    }
+    m_format = Format::PCAP;
+    m_linkType = read32(20);
+    if (m_linkType != LINKTYPE_NULL && m_linkType != LINKTYPE_ETHERNET && m_linkType != LINKTYPE_RAW &&
+        m_linkType != LINKTYPE_LINUX_SLL && m_linkType != LINKTYPE_LINUX_SLL2) {
+      throw std::runtime_error(filename + " has unsupported link type " + std::to_string(m_linkType));
+    }
+    m_offset = PCAP_HEADER_SIZE;
+  }
+
+  Format
+  getFormat() const
+  {
+    return m_format;
+  }
+
+  /**
+   * \brief Returns the names of the traffic patterns of a binary trace.
+   */
+  const std::vector<std::string>&
+  getPatternNames() const
+  {
+    return m_patternNames;
+  }
+
+  /**
+   * \brief Returns the number of pcap frames that are not NDN packets.
+   */
+  uint64_t
+  getSkippedFrames() const
+  {
+    return m_nSkippedFrames;
+  }
+
+  /**
+   * \brief Returns the number of binary trace records that were too far out of order to be
+   *        put back in place, and have been replayed late.
+   */
+  uint64_t
+  getLateRecords() const
+  {
+    return m_nLateRecords;
+  }
+
+  /**
+   * \brief Reads the next packet.
+   * \return false at the end of the file
+   */
+  bool
+  next(ReplayEvent& event)
+  {
+    bool hasEvent = m_format == Format::PCAP ? nextPcap(event) : nextTrace(event);
+    if (m_offset - m_releasedOffset >= RELEASE_INTERVAL) {
+      m_file.release(m_offset);
+      m_releasedOffset = m_offset;
+    }
+    return hasEvent;
+  }
+
+private:
+  void
+  readTraceHeader()
+  {
+    m_offset = sizeof(trace::MAGIC);
+    auto readInteger = [this] {
+      if (m_contents.size() - m_offset < sizeof(uint32_t)) {
+        throw std::runtime_error("truncated trace file header");
+      }
+      uint32_t n = 0;
+      std::memcpy(&n, m_contents.data() + m_offset, sizeof(n));
+      m_offset += sizeof(n);
+      return n;
+    };
+    auto nPatterns = readInteger();
+    for (uint32_t i = 0; i < nPatterns; i++) {
+      auto length = readInteger();
+      if (m_contents.size() - m_offset < length) {
+        throw std::runtime_error("truncated trace file header");
+      }
+      m_patternNames.emplace_back(m_contents.substr(m_offset, length));
+      m_offset += length;
+    }
+  }
+
+  /**
+   * Each worker writes its records in blocks of trace::BLOCK_SIZE, so consecutive records of
+   * different workers are out of order by up to one block per worker; a bounded min-heap,
+   * large enough for TRACE_REORDER_BLOCKS workers, puts them back in order.
+   */
+  bool
+  nextTrace(ReplayEvent& event)
+  {
+    while (m_pending.size() < TRACE_REORDER_WINDOW && m_contents.size() - m_offset >= sizeof(trace::TraceRecord)) {
+      trace::TraceRecord record;
+      std::memcpy(&record, m_contents.data() + m_offset, sizeof(record));
+      m_offset += sizeof(record);
+      if (record.m_type == trace::EventType::INTEREST_SENT) {
+        m_pending.emplace(record.m_sendTime, record.m_patternId);
+      }
+    }
+    if (m_pending.empty()) {
+      return false;
+    }
+
+    auto [sendTime, patternId] = m_pending.top();
+    m_pending.pop();
+    if (!m_firstTime) {
+      m_firstTime = sendTime;
+    }
+    // a record older than one already returned (more disorder than the window): send it right away
+    if (sendTime - *m_firstTime < m_lastTime) {
+      m_nLateRecords++;
+    }
+    m_lastTime = std::max(m_lastTime, sendTime - *m_firstTime);
+    event.m_time = std::chrono::nanoseconds(m_lastTime);
+    event.m_packet = {};
+    event.m_patternId = patternId;
+    return true;
+  }
+
+  bool
+  nextPcap(ReplayEvent& event)
+  {
+    while (m_contents.size() - m_offset >= PCAP_RECORD_HEADER_SIZE) {
+      int64_t seconds = read32(m_offset);
+      int64_t fraction = read32(m_offset + 4);
+      std::size_t length = read32(m_offset + 8);
+      m_offset += PCAP_RECORD_HEADER_SIZE;
+      if (m_contents.size() - m_offset < length) {
+        // a capture that was interrupted while writing
+        m_offset = m_contents.size();
+        return false;
+      }
+      auto frame = m_contents.substr(m_offset, length);
+      m_offset += length;
+
+      auto packet = decodeFrame(frame);
+      if (!packet) {
+        m_nSkippedFrames++;
+        continue;
+      }
+
+      int64_t time = seconds * 1000000000 + fraction * (m_isNanosecond ? 1 : 1000);
+      if (!m_firstTime) {
+        m_firstTime = time;
+      }
+      m_lastTime = std::max(m_lastTime, time - *m_firstTime);
+      event.m_time = std::chrono::nanoseconds(m_lastTime);
+      event.m_packet = std::move(*packet);
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * \brief Returns the NDN packet in \p frame, if there is one.
+   */
+  std::optional<ndn::Block>
+  decodeFrame(std::string_view frame) const
+  {
+    uint16_t etherType = 0;
+    switch (m_linkType) {
+      case LINKTYPE_NULL:
+      case LINKTYPE_RAW:
+        if (m_linkType == LINKTYPE_NULL) {
+          if (frame.size() < 4) {
+            return std::nullopt;
+          }
+          frame.remove_prefix(4);
+        }
+        if (frame.empty()) {
+          return std::nullopt;
+        }
+        etherType = (static_cast<uint8_t>(frame[0]) >> 4) == 6 ? ETHERTYPE_IPV6 : ETHERTYPE_IPV4;
+        break;
+      case LINKTYPE_ETHERNET:
+        if (frame.size() < 14) {
+          return std::nullopt;
+        }
+        etherType = readBigEndian16(frame, 12);
+        frame.remove_prefix(14);
+        if (etherType == ETHERTYPE_VLAN && frame.size() >= 4) {
+          etherType = readBigEndian16(frame, 2);
+          frame.remove_prefix(4);
+        }
+        break;
+      case LINKTYPE_LINUX_SLL:
+        if (frame.size() < 16) {
+          return std::nullopt;
+        }
+        etherType = readBigEndian16(frame, 14);
+        frame.remove_prefix(16);
+        break;
+      case LINKTYPE_LINUX_SLL2:
+        if (frame.size() < 20) {
+          return std::nullopt;
+        }
+        etherType = readBigEndian16(frame, 0);
+        frame.remove_prefix(20);
+        break;
+    }
+
+    if (etherType == ETHERTYPE_IPV4) {
+      if (frame.size() < 20 || (static_cast<uint8_t>(frame[0]) >> 4) != 4) {
+        return std::nullopt;
+      }
+      std::size_t headerLength = (static_cast<uint8_t>(frame[0]) & 0x0f) * 4;
+      // more fragments, or not the first fragment
+      bool isFragment = (readBigEndian16(frame, 6) & 0x3fff) != 0;
+      if (static_cast<uint8_t>(frame[9]) != IPPROTO_UDP_NUMBER || isFragment || frame.size() < headerLength) {
+        return std::nullopt;
+      }
+      frame.remove_prefix(headerLength);
+      return decodeUdp(frame);
+    }
+    if (etherType == ETHERTYPE_IPV6) {
+      if (frame.size() < 40 || static_cast<uint8_t>(frame[6]) != IPPROTO_UDP_NUMBER) {
+        return std::nullopt;
+      }
+      frame.remove_prefix(40);
+      return decodeUdp(frame);
+    }
+    if (etherType == ETHERTYPE_NDN) {
+      // Ethernet frames may be padded
+      return decodePacket(frame);
+    }
+    return std::nullopt;
+  }
+
+  static std::optional<ndn::Block>
+  decodeUdp(std::string_view datagram)
+  {
+    if (datagram.size() < 8) {
+      return std::nullopt;
+    }
+    auto isNdnPort = [] (uint16_t port) { return port == 6363 || port == 56363; };
+    if (!isNdnPort(readBigEndian16(datagram, 0)) && !isNdnPort(readBigEndian16(datagram, 2))) {
+      return std::nullopt;
+    }
+    datagram.remove_prefix(8);
+    return decodePacket(datagram);
+  }
+
+  /**
+   * \brief Decodes an Interest or a Data, which may be the fragment of an unfragmented LpPacket.
+   */
+  static std::optional<ndn::Block>
+  decodePacket(std::string_view payload)
+  {
+    auto [isOk, block] = ndn::Block::fromBuffer(ndn::make_span(reinterpret_cast<const uint8_t*>(payload.data()),
+                                                               payload.size()));
+    if (!isOk) {
+      return std::nullopt;
+    }
+    if (block.type() == ndn::lp::tlv::LpPacket) {
+      try {
+        ndn::lp::Packet lpPacket(block);
+        // Nacks carry an Interest too, but are not Interests to replay
+        if (!lpPacket.has<ndn::lp::FragmentField>() || lpPacket.has<ndn::lp::NackField>() ||
+            (lpPacket.has<ndn::lp::FragCountField>() && lpPacket.get<ndn::lp::FragCountField>() > 1)) {
+          return std::nullopt;
+        }
+        auto [begin, end] = lpPacket.get<ndn::lp::FragmentField>();
+        std::tie(isOk, block) = ndn::Block::fromBuffer(ndn::make_span(&*begin, static_cast<std::size_t>(end - begin)));
+      }
+      catch (const std::exception&) {
+        return std::nullopt;
+      }
+      if (!isOk) {
+        return std::nullopt;
+      }
+    }
+    if (block.type() != ndn::tlv::Interest && block.type() != ndn::tlv::Data) {
+      return std::nullopt;
+    }
+    return block;
+  }
+
+  uint32_t
+  read32(std::size_t offset) const
+  {
+    uint32_t n = 0;
+    std::memcpy(&n, m_contents.data() + offset, sizeof(n));
+    return m_isSwapped ? __builtin_bswap32(n) : n;
+  }
+
+  static uint16_t
+  readBigEndian16(std::string_view bytes, std::size_t offset)
+  {
+    return static_cast<uint16_t>((static_cast<uint8_t>(bytes[offset]) << 8) | static_cast<uint8_t>(bytes[offset + 1]));
+  }
+
+private:
+  static constexpr std::size_t PCAP_HEADER_SIZE = 24;
+  static constexpr std::size_t PCAP_RECORD_HEADER_SIZE = 16;
+  static constexpr uint32_t LINKTYPE_NULL = 0;
+  static constexpr uint32_t LINKTYPE_ETHERNET = 1;
+  static constexpr uint32_t LINKTYPE_RAW = 101;
+  static constexpr uint32_t LINKTYPE_LINUX_SLL = 113;
+  static constexpr uint32_t LINKTYPE_LINUX_SLL2 = 276;
+  static constexpr uint16_t ETHERTYPE_IPV4 = 0x0800;
+  static constexpr uint16_t ETHERTYPE_IPV6 = 0x86dd;
+  static constexpr uint16_t ETHERTYPE_VLAN = 0x8100;
+  static constexpr uint16_t ETHERTYPE_NDN = 0x8624;
+  static constexpr uint8_t IPPROTO_UDP_NUMBER = 17;
+  static constexpr std::size_t TRACE_REORDER_BLOCKS = 64;
+  static constexpr std::size_t TRACE_REORDER_WINDOW = TRACE_REORDER_BLOCKS * trace::BLOCK_SIZE;
+  static constexpr std::size_t RELEASE_INTERVAL = 64 * 1024 * 1024;
+
+  MappedFile m_file;
+  std::string_view m_contents;
+  std::size_t m_offset = 0;
+  std::size_t m_releasedOffset = 0;
+  Format m_format = Format::PCAP;
+
+  // pcap only
+  bool m_isSwapped = false;
+  bool m_isNanosecond = false;
+  uint32_t m_linkType = 0;
+  uint64_t m_nSkippedFrames = 0;
+
+  // binary trace only
+  std::vector<std::string> m_patternNames;
+  std::priority_queue<std::pair<int64_t, std::size_t>, std::vector<std::pair<int64_t, std::size_t>>,
+                      std::greater<>> m_pending; ///< send time and pattern ID
+  uint64_t m_nLateRecords = 0;
+
+  std::optional<int64_t> m_firstTime; ///< nanoseconds
+  int64_t m_lastTime = 0;             ///< nanoseconds since m_firstTime
+};
+
+} // namespace ndntg
+
+#endif // NDNTG_REPLAY_HPP
@@ -0,0 +1,250 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2023, Arizona Board of Regents.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NDNTG_TRACE_HPP
+#define NDNTG_TRACE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+
+namespace ndntg {
+
+/**
+ * \brief Binary per-packet trace file format.
+ *
+ * A trace file starts with a header: the 8-byte magic "NDNTGTR1", the number of traffic
+ * patterns (uint32), then for each pattern the length (uint32) and bytes of its Name URI.
+ * It is followed by any number of fixed-size TraceRecord entries. All integers are stored
+ * in host byte order, so a trace is meant to be decoded on the same architecture.
+ */
+namespace trace {
+
+constexpr char MAGIC[8] = {'N', 'D', 'N', 'T', 'G', 'T', 'R', '1'};
+
+/**
+ * \brief Number of records that each worker writes out in one block.
+ */
+constexpr std::size_t BLOCK_SIZE = 4096;
+
+enum class EventType : uint8_t {
+  INTEREST_SENT = 1,
+  DATA_RECEIVED = 2,
+  NACK_RECEIVED = 3,
+  TIMEOUT = 4,
+  LATE_DATA_RECEIVED = 5, ///< Data for an Interest already counted as timed out
+};
+
+inline const char*
+toString(EventType type)
+{
+  switch (type) {
+    case EventType::INTEREST_SENT:
+      return "InterestSent";
+    case EventType::DATA_RECEIVED:
+      return "DataReceived";
+    case EventType::NACK_RECEIVED:
+      return "NackReceived";
+    case EventType::TIMEOUT:
+      return "Timeout";
+    case EventType::LATE_DATA_RECEIVED:
+      return "LateDataReceived";
+  }
+  return "Unknown";
+}
+
+class TraceRecord
+{
+public:
+  EventType m_type;
+  uint8_t m_reserved[3] = {};
+  uint32_t m_patternId;
+  uint64_t m_globalId;
+  uint64_t m_localId;
+  uint32_t m_nonce;
+  uint32_t m_nackReason;
+  int64_t m_sendTime;    ///< steady clock, nanoseconds
+  int64_t m_receiveTime; ///< steady clock, nanoseconds; 0 if not applicable
+};
+
+static_assert(sizeof(TraceRecord) == 48, "TraceRecord must not contain padding");
+
+/**
+ * \brief Writes trace records to a file, on behalf of any number of threads.
+ *
+ * Each thread accumulates records in its own Buffer, which is written out in one
+ * piece, under a lock, whenever it fills up.
+ */
+class TraceWriter : boost::noncopyable
+{
+public:
+  class Buffer : boost::noncopyable
+  {
+  public:
+    explicit
+    Buffer(TraceWriter& writer)
+      : m_writer(writer)
+    {
+      m_records.reserve(BLOCK_SIZE);
+    }
+
+    ~Buffer()
+    {
+      flush();
+    }
+
+    void
+    append(const TraceRecord& record)
+    {
+      m_records.push_back(record);
+      if (m_records.size() >= BLOCK_SIZE) {
+        flush();
+      }
+    }
+
+    void
+    flush()
+    {
+      m_writer.write(m_records);
+      m_records.clear();
+    }
+
+  private:
+    TraceWriter& m_writer;
+    std::vector<TraceRecord> m_records;
+  };
+
+  /**
+   * \throw std::runtime_error the file cannot be opened
+   */
+  TraceWriter(const std::string& filename, const std::vector<std::string>& patternNames)
+    : m_file(filename, std::ofstream::binary | std::ofstream::trunc)
+  {
+    if (!m_file) {
+      throw std::runtime_error("cannot open trace file " + filename);
+    }
+
+    m_file.write(MAGIC, sizeof(MAGIC));
+    writeInteger(static_cast<uint32_t>(patternNames.size()));
+    for (const auto& name : patternNames) {
+      writeInteger(static_cast<uint32_t>(name.size()));
+      m_file.write(name.data(), name.size());
+    }
+  }
+
+  void
+  write(const std::vector<TraceRecord>& records)
+  {
+    if (records.empty()) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(TraceRecord));
+    m_file.flush();
+  }
+
+private:
+  void
+  writeInteger(uint32_t n)
+  {
+    m_file.write(reinterpret_cast<const char*>(&n), sizeof(n));
+  }
+
+private:
+  std::ofstream m_file;
+  std::mutex m_mutex;
+};
+
+/**
+ * \brief Reads a trace file written by TraceWriter.
+ */
+class TraceReader : boost::noncopyable
+{
+public:
+  /**
+   * \throw std::runtime_error the file cannot be opened or has an invalid header
+   */
+  explicit
+  TraceReader(const std::string& filename)
+    : m_file(filename, std::ifstream::binary)
+  {
+    if (!m_file) {
+      throw std::runtime_error("cannot open trace file " + filename);
+    }
+
+    char magic[sizeof(MAGIC)];
+    if (!m_file.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+      throw std::runtime_error(filename + " is not a trace file");
+    }
+
+    auto nPatterns = readInteger();
+    for (uint32_t i = 0; i < nPatterns; i++) {
+      std::string name(readInteger(), '\0');
+      if (!m_file.read(name.data(), name.size())) {
+        throw std::runtime_error("truncated trace file header");
+      }
+      m_patternNames.push_back(std::move(name));
+    }
+  }
+
+  const std::vector<std::string>&
+  getPatternNames() const
+  {
+    return m_patternNames;
+  }
+
+  /**
+   * \brief Reads up to \p maxRecords records into \p records.
+   * \return false at the end of the file
+   */
+  bool
+  read(std::vector<TraceRecord>& records, std::size_t maxRecords = 4096)
+  {
+    records.resize(maxRecords);
+    m_file.read(reinterpret_cast<char*>(records.data()), maxRecords * sizeof(TraceRecord));
+    records.resize(static_cast<std::size_t>(m_file.gcount()) / sizeof(TraceRecord));
+    return !records.empty();
+  }
+
+private:
+  uint32_t
+  readInteger()
+  {
+    uint32_t n = 0;
+    if (!m_file.read(reinterpret_cast<char*>(&n), sizeof(n))) {
+      throw std::runtime_error("truncated trace file header");
+    }
+    return n;
+  }
+
+private:
+  std::ifstream m_file;
+  std::vector<std::string> m_patternNames;
+};
+
+} // namespace trace
+} // namespace ndntg
+
+#endif // NDNTG_TRACE_HPP
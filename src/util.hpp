@@ -23,45 +23,60 @@
 
 #include "logger.hpp"
 
+#include <array>
 #include <cctype>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/core/noncopyable.hpp>
 
 namespace ndntg {
 
+/**
+ * \brief Splits a configuration line of the form `Parameter=Value`.
+ *
+ * This is a single pass over the line, with a table lookup for every character of the value.
+ * The results point into \p input.
+ */
 inline bool
-extractParameterAndValue(const std::string& input, std::string& parameter, std::string& value)
+extractParameterAndValue(std::string_view input, std::string_view& parameter, std::string_view& value)
 {
-  static const std::string allowedCharacters = ":/+._-%";
-  parameter = "";
-  value = "";
-
-  std::size_t i = 0;
-  // parse the parameter name
-  while (i < input.length() && input[i] != '=') {
-    parameter += input[i];
-    i++;
-  }
-  if (i == input.length()) {
+  static const auto isAllowed = [] {
+    std::array<bool, 256> table{};
+    for (int c = 0; c < 256; c++) {
+      table[c] = std::isalnum(c) != 0;
+    }
+    for (unsigned char c : std::string_view(":/+._-%")) {
+      table[c] = true;
+    }
+    return table;
+  }();
+
+  auto equalSign = input.find('=');
+  if (equalSign == std::string_view::npos) {
     return false;
   }
+  parameter = input.substr(0, equalSign);
+  value = input.substr(equalSign + 1);
 
-  // skip the equal sign
-  i++;
-
-  // parse the value
-  while (i < input.length() &&
-         (std::isalnum(input[i]) || allowedCharacters.find(input[i]) != std::string::npos)) {
-    value += input[i];
-    i++;
+  for (unsigned char c : value) {
+    if (!isAllowed[c]) {
+      return false;
+    }
   }
-
-  return !parameter.empty() && !value.empty() && i == input.length();
+  return !parameter.empty() && !value.empty();
 }
 
 inline bool
-parseBoolean(const std::string& input)
+parseBoolean(std::string_view input)
 {
   if (boost::iequals(input, "no") || boost::iequals(input, "off") ||
       boost::iequals(input, "false") || input == "0")
@@ -71,51 +86,187 @@ parseBoolean(const std::string& input)
       boost::iequals(input, "true") || input == "1")
     return true;
 
-  throw std::invalid_argument("'" + input + "' is not a valid boolean value");
+  throw std::invalid_argument("'" + std::string(input) + "' is not a valid boolean value");
 }
 
-template<typename TrafficConfigurationType>
-bool
-readConfigurationFile(const std::string& filename,
-                      std::vector<TrafficConfigurationType>& patterns,
-                      Logger& logger)
+/**
+ * \brief Read-only view of the whole contents of a file.
+ *
+ * Regular files are memory-mapped; anything else, e.g. a pipe, is read into memory.
+ */
+class MappedFile : boost::noncopyable
 {
-  std::ifstream patternFile(filename);
-  if (!patternFile) {
-    logger.log("ERROR: Unable to open traffic configuration file: " + filename, false, true);
-    return false;
+public:
+  explicit
+  MappedFile(const std::string& filename)
+  {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      return;
+    }
+
+    if (S_ISREG(st.st_mode)) {
+      m_isOpen = true;
+      m_size = static_cast<std::size_t>(st.st_size);
+      if (m_size > 0) {
+        void* addr = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+          ::madvise(addr, m_size, MADV_SEQUENTIAL);
+          m_mapping = addr;
+        }
+        else {
+          m_isOpen = readAll(fd);
+        }
+      }
+    }
+    else if (!S_ISDIR(st.st_mode)) {
+      m_isOpen = readAll(fd);
+    }
+    ::close(fd);
   }
 
-  logger.log("Reading traffic configuration file: " + filename, true, true);
+  ~MappedFile()
+  {
+    if (m_mapping != nullptr) {
+      ::munmap(m_mapping, m_size);
+    }
+  }
+
+  explicit
+  operator bool() const
+  {
+    return m_isOpen;
+  }
+
+  std::string_view
+  getContents() const
+  {
+    if (m_mapping != nullptr) {
+      return {static_cast<const char*>(m_mapping), m_size};
+    }
+    return m_buffer;
+  }
+
+  /**
+   * \brief Lets the kernel reclaim the memory of the first \p length bytes of the contents,
+   *        which must not be accessed again, so that reading a large file from start to end
+   *        does not keep all of it resident.
+   */
+  void
+  release(std::size_t length)
+  {
+    if (m_mapping == nullptr) {
+      return;
+    }
+    auto pageSize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    length -= length % pageSize;
+    if (length > m_releasedLength) {
+      ::madvise(static_cast<char*>(m_mapping) + m_releasedLength, length - m_releasedLength, MADV_DONTNEED);
+      m_releasedLength = length;
+    }
+  }
+
+private:
+  bool
+  readAll(int fd)
+  {
+    char buf[65536];
+    ssize_t n = 0;
+    while ((n = ::read(fd, buf, sizeof(buf))) > 0) {
+      m_buffer.append(buf, static_cast<std::size_t>(n));
+    }
+    return n == 0;
+  }
+
+private:
+  bool m_isOpen = false;
+  void* m_mapping = nullptr;
+  std::size_t m_size = 0;
+  std::size_t m_releasedLength = 0;
+  std::string m_buffer;
+};
+
+/**
+ * \brief Parses the traffic patterns in the contents of a configuration file.
+ *
+ * Each pattern is a block of consecutive lines that start with a letter; any other line,
+ * typically a row of '#', separates patterns. A pattern that contains an invalid line or
+ * fails checkTrafficDetailCorrectness() is skipped as a whole.
+ */
+template<typename TrafficConfigurationType>
+void
+parseConfiguration(std::string_view contents,
+                   std::vector<TrafficConfigurationType>& patterns,
+                   Logger& logger)
+{
+  std::optional<TrafficConfigurationType> pattern;
+  bool isValid = false;
+  int firstLineNumber = 0;
+  auto finishPattern = [&] {
+    if (pattern && isValid && pattern->checkTrafficDetailCorrectness(logger, firstLineNumber)) {
+      patterns.push_back(std::move(*pattern));
+    }
+    pattern.reset();
+  };
 
   int lineNumber = 0;
-  std::string patternLine;
-  while (getline(patternFile, patternLine)) {
+  while (!contents.empty()) {
+    auto endOfLine = contents.find('\n');
+    auto line = contents.substr(0, endOfLine);
+    contents.remove_prefix(endOfLine == std::string_view::npos ? contents.size() : endOfLine + 1);
+    if (!line.empty() && line.back() == '\r') {
+      line.remove_suffix(1);
+    }
     lineNumber++;
-    if (std::isalpha(patternLine[0])) {
-      TrafficConfigurationType trafficConf;
-      bool shouldSkipLine = false;
-      if (trafficConf.parseConfigurationLine(patternLine, logger, lineNumber)) {
-        while (getline(patternFile, patternLine) && std::isalpha(patternLine[0])) {
-          lineNumber++;
-          if (!trafficConf.parseConfigurationLine(patternLine, logger, lineNumber)) {
-            shouldSkipLine = true;
-            break;
-          }
-        }
-        lineNumber++;
-      }
-      else {
-        shouldSkipLine = true;
+
+    if (line.empty() || !std::isalpha(static_cast<unsigned char>(line.front()))) {
+      finishPattern();
+      continue;
+    }
+
+    if (!pattern) {
+      pattern.emplace();
+      isValid = true;
+      firstLineNumber = lineNumber;
+    }
+    if (isValid) {
+      try {
+        isValid = pattern->parseConfigurationLine(line, logger, lineNumber);
       }
-      if (!shouldSkipLine) {
-        if (trafficConf.checkTrafficDetailCorrectness()) {
-          patterns.push_back(std::move(trafficConf));
-        }
+      catch (const std::exception& e) {
+        logger.log("Line " + std::to_string(lineNumber) + " - Invalid value: " + std::string(line) +
+                   " (" + e.what() + ")", false, true);
+        isValid = false;
       }
     }
   }
+  finishPattern();
+}
 
+/**
+ * \brief Reads the traffic patterns from a configuration file.
+ * \sa parseConfiguration
+ */
+template<typename TrafficConfigurationType>
+bool
+readConfigurationFile(const std::string& filename,
+                      std::vector<TrafficConfigurationType>& patterns,
+                      Logger& logger)
+{
+  MappedFile file(filename);
+  if (!file) {
+    logger.log("ERROR: Unable to open traffic configuration file: " + filename, false, true);
+    return false;
+  }
+
+  logger.log("Reading traffic configuration file: " + filename, true, true);
+  parseConfiguration(file.getContents(), patterns, logger);
   return true;
 }
 